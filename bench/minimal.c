@@ -0,0 +1,54 @@
+// A minimal program that parses its command line, used by startup.c.
+//
+// Configurations are selected at compile time (see Makefile).
+
+#ifdef CLI_NO_STDIO_H
+// cli.h does not include <stdio.h>, but fprintf() and stderr are still needed.
+#include <stdio.h>
+#endif
+
+#ifdef BENCH_CUSTOM_MALLOC
+#include <stddef.h>
+#include <string.h>
+
+// A bump allocator, so the heap of libc is never initialized.
+static _Alignas(16) char bench_heap[1 << 16];
+static size_t bench_used = 0;
+
+static void* bench_malloc(size_t size) {
+    size = (size + 15) & ~(size_t)15;
+    if (size > sizeof(bench_heap) - bench_used) {
+        return NULL;
+    }
+    bench_used += size;
+    return bench_heap + bench_used - size;
+}
+
+// Blocks are never moved backwards, so copying `size` bytes stays in the heap.
+static void* bench_realloc(void* ptr, size_t size) {
+    void* result = bench_malloc(size);
+    if (result && ptr) {
+        memcpy(result, ptr, size);
+    }
+    return result;
+}
+
+#define CLI_MALLOC     bench_malloc
+#define CLI_REALLOC    bench_realloc
+#define CLI_FREE(ptr)  ((void)(ptr))
+#endif // BENCH_CUSTOM_MALLOC
+
+#define CLI_IMPLEMENTATION
+#include "cli.h"
+
+int main(int argc, char** argv) {
+    Cli cli;
+#ifdef CLI_NOHEAP
+    const char* stack[CLI_STACK_SIZE(argc)];
+    return cli_parse_noheap(argc, argv, &cli, stack);
+#else
+    enum CliError error = cli_parse(argc, argv, &cli);
+    cli_free(&cli);
+    return error;
+#endif
+}
@@ -0,0 +1,201 @@
+// A benchmark of parsing synthetic command lines.
+//
+// Usage: ./parse-<mode> <shape> <tokens>
+//
+// The mode is selected at compile time (see Makefile), while shapes are:
+//     options     Program options only (`--option7=7`).
+//     positional  Positional arguments only (`file7`).
+//     dashdash    Double dashes followed by command options (`-- -c7`).
+//     mixed       A quarter of program options, a half of positional
+//                 arguments and a quarter of command options.
+//
+// With CLI_RESPONSE_FILES, tokens are written to a temporary response file,
+// which is passed as the only argument (`@path`).
+//
+// Prints a single JSON object per run.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+
+static size_t bench_allocations = 0;
+static size_t bench_reallocations = 0;
+
+static void* bench_malloc(size_t size) {
+    bench_allocations++;
+    return malloc(size);
+}
+
+static void* bench_realloc(void* ptr, size_t size) {
+    bench_reallocations++;
+    return realloc(ptr, size);
+}
+
+#define CLI_MALLOC  bench_malloc
+#define CLI_REALLOC bench_realloc
+#define CLI_IMPLEMENTATION
+#include "cli.h"
+
+#ifndef BENCH_MODE
+#define BENCH_MODE "default"
+#endif
+
+// The number of tokens to parse in total, so small command lines are repeated.
+#define BENCH_TOKENS 20000000
+
+static unsigned long long bench_now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (unsigned long long)time.tv_sec * 1000000000 + time.tv_nsec;
+}
+
+// Fill `argv` (with the executable file) and return false for unknown shapes.
+static bool bench_generate(const char* shape, int tokens, char** argv) {
+    argv[0] = "bench";
+    for (int i = 1; i <= tokens; i++) {
+        char buffer[32];
+        if (strcmp(shape, "options") == 0) {
+            snprintf(buffer, sizeof(buffer), "--option%d=%d", i, i);
+        } else if (strcmp(shape, "positional") == 0) {
+            snprintf(buffer, sizeof(buffer), "file%d", i);
+        } else if (strcmp(shape, "dashdash") == 0) {
+            snprintf(buffer, sizeof(buffer), i % 2 ? "--" : "-c%d", i);
+        } else if (strcmp(shape, "mixed") == 0) {
+            const char* format = "-c%d";
+            if (i <= tokens / 4) {
+                format = "--option%d";
+            } else if (i <= tokens / 4 * 3) {
+                format = "file%d";
+            }
+            snprintf(buffer, sizeof(buffer), format, i);
+        } else {
+            return false;
+        }
+        argv[i] = strdup(buffer);
+    }
+    argv[tokens + 1] = NULL;
+    return true;
+}
+
+#ifdef CLI_RESPONSE_FILES
+static char bench_response_path[] = "/tmp/cli-bench-XXXXXX";
+
+static void bench_remove_response_file(void) { remove(bench_response_path); }
+
+// Move tokens of `argv` to a response file and replace them with `@path`.
+static bool bench_write_response_file(int tokens, char** argv) {
+    int fd = mkstemp(bench_response_path);
+    FILE* file = fd < 0 ? NULL : fdopen(fd, "w");
+    if (file == NULL) {
+        return false;
+    }
+    atexit(bench_remove_response_file);
+    for (int i = 1; i <= tokens; i++) {
+        fprintf(file, "%s\n", argv[i]);
+    }
+    if (fclose(file) != 0) {
+        return false;
+    }
+    static char arg[sizeof(bench_response_path) + 1];
+    snprintf(arg, sizeof(arg), "@%s", bench_response_path);
+    argv[1] = arg;
+    argv[2] = NULL;
+    return true;
+}
+#endif
+
+#ifdef BENCH_EACH
+static enum CliError bench_visit(enum CliToken kind, const char* token, void* userdata) {
+    (void)token;
+    ((size_t*)userdata)[kind]++;
+    return CliErrorOk;
+}
+#endif
+
+// Parse the command line once, including freeing of memory unless it is reused.
+static enum CliError bench_parse(int argc, char** argv, Cli* cli, const char** stack) {
+    (void)stack;
+#if defined(BENCH_EACH)
+    (void)cli;
+    size_t counts[CliTokenDoubleDash] = { 0 };
+    return cli_parse_each(argc, argv, bench_visit, counts);
+#elif defined(BENCH_INTO)
+    return cli_parse_into(argc, argv, cli);
+#else
+#if defined(CLI_NOHEAP)
+    enum CliError error = cli_parse_noheap(argc, argv, cli, stack);
+#elif defined(BENCH_EXACT)
+    enum CliError error = cli_parse_exact(argc, argv, cli);
+#else
+    enum CliError error = cli_parse(argc, argv, cli);
+#endif
+    cli_free(cli);
+    return error;
+#endif
+}
+
+int main(int argc, char** argv) {
+    if (argc != 3 || atoi(argv[2]) <= 0) {
+        cli_print_error("Usage", "parse-<mode> <shape> <tokens>");
+        return CliErrorUser;
+    }
+    const char* shape = argv[1];
+    int tokens = atoi(argv[2]);
+    // Some modes never allocate or reallocate.
+    (void)bench_malloc;
+    (void)bench_realloc;
+
+    char** bench_argv = (char**)malloc((tokens + 2) * sizeof(char*));
+    if (bench_argv == NULL || !bench_generate(shape, tokens, bench_argv)) {
+        cli_printf_error("Usage", "Unknown shape ('%s').", shape);
+        return CliErrorUser;
+    }
+    int bench_argc = tokens + 1;
+#ifdef CLI_RESPONSE_FILES
+    if (!bench_write_response_file(tokens, bench_argv)) {
+        cli_print_error("Error", "Unable to write the response file.");
+        return CliErrorFatal;
+    }
+    bench_argc = 2;
+#endif
+#ifdef CLI_NOHEAP
+    const char** stack = (const char**)malloc(CLI_STACK_SIZE(tokens + 1) * sizeof(const char*));
+#else
+    const char** stack = NULL;
+#endif
+
+    Cli cli = { 0 };
+    // The first parse is measured separately: it shows allocations of a cold parse.
+    size_t allocations = bench_allocations, reallocations = bench_reallocations;
+    if (bench_parse(bench_argc, bench_argv, &cli, stack)) {
+        return CliErrorFatal;
+    }
+    allocations = bench_allocations - allocations;
+    reallocations = bench_reallocations - reallocations;
+
+    int iterations = BENCH_TOKENS / tokens;
+    iterations = iterations < 3 ? 3 : iterations;
+    size_t steady_allocations = bench_allocations + bench_reallocations;
+    unsigned long long start = bench_now();
+    for (int i = 0; i < iterations; i++) {
+        bench_parse(bench_argc, bench_argv, &cli, stack);
+    }
+    unsigned long long elapsed = bench_now() - start;
+    steady_allocations = bench_allocations + bench_reallocations - steady_allocations;
+#ifdef BENCH_INTO
+    cli_free(&cli);
+#endif
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    printf(
+        "{\"mode\": \"%s\", \"shape\": \"%s\", \"tokens\": %d, \"iterations\": %d, "
+        "\"ns_per_token\": %.3f, \"allocations\": %zu, \"reallocations\": %zu, "
+        "\"steady_allocations_per_parse\": %.3f, \"peak_rss_kb\": %ld}\n",
+        BENCH_MODE, shape, tokens, iterations, (double)elapsed / iterations / tokens, allocations,
+        reallocations, (double)steady_allocations / iterations, usage.ru_maxrss
+    );
+    return CliErrorOk;
+}
@@ -0,0 +1,85 @@
+// A benchmark of the startup latency of programs built with cli.h.
+//
+// Usage: ./startup <runs> <program>...
+//
+// Every program is spawned `runs` times with a short command line. Prints
+// a single JSON object per program with percentiles of the wall time (from
+// spawning to reaping the process), the size of the binary and the average
+// number of page faults.
+
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+
+extern char** environ;
+
+static unsigned long long bench_now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (unsigned long long)time.tv_sec * 1000000000 + time.tv_nsec;
+}
+
+static int bench_compare(const void* a, const void* b) {
+    unsigned long long x = *(const unsigned long long*)a;
+    unsigned long long y = *(const unsigned long long*)b;
+    return (x > y) - (x < y);
+}
+
+// Spawn `program` `runs` times and print the results. Returns 0 on success.
+static int bench_program(char* program, int runs, unsigned long long* times) {
+    char* argv[] = { program, "--verbose", "-j=4", "input.txt", "output.txt", "-f", NULL };
+    unsigned long long faults = 0;
+    for (int i = 0; i < runs; i++) {
+        unsigned long long start = bench_now();
+        pid_t pid;
+        if (posix_spawn(&pid, program, NULL, NULL, argv, environ) != 0) {
+            fprintf(stderr, "Unable to spawn '%s'.\n", program);
+            return 1;
+        }
+        int status;
+        struct rusage usage;
+        if (wait4(pid, &status, 0, &usage) != pid || !WIFEXITED(status)
+            || WEXITSTATUS(status) != 0) {
+            fprintf(stderr, "'%s' has failed.\n", program);
+            return 1;
+        }
+        times[i] = bench_now() - start;
+        faults += usage.ru_minflt + usage.ru_majflt;
+    }
+    qsort(times, runs, sizeof(*times), bench_compare);
+
+    struct stat file;
+    if (stat(program, &file) != 0) {
+        return 1;
+    }
+    printf(
+        "{\"program\": \"%s\", \"runs\": %d, \"p50_us\": %.1f, \"p99_us\": %.1f, "
+        "\"binary_bytes\": %lld, \"page_faults\": %.1f}\n",
+        program, runs, times[runs / 2] / 1e3, times[(runs - 1) * 99 / 100] / 1e3,
+        (long long)file.st_size, (double)faults / runs
+    );
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    int runs = argc > 2 ? atoi(argv[1]) : 0;
+    if (runs <= 0) {
+        fprintf(stderr, "Usage: startup <runs> <program>...\n");
+        return 1;
+    }
+    unsigned long long* times = (unsigned long long*)malloc(runs * sizeof(*times));
+    if (times == NULL) {
+        return 1;
+    }
+    for (int i = 2; i < argc; i++) {
+        if (bench_program(argv[i], runs, times)) {
+            return 1;
+        }
+    }
+    free(times);
+    return 0;
+}
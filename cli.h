@@ -42,9 +42,92 @@
 //     CLI_NOHEAP_IMPLEMENTATION
 //         Do not allocate arguments on the heap. For more information, see
 //         below.
+//     CLI_ARENA
+//         Allocate all dynamic arrays of Cli within a single block of `argc`
+//         pointers. cli_parse() makes exactly one allocation and no
+//         reallocations. Ignored if CLI_NOHEAP is defined.
+//     CLI_OPTION_VIEWS
+//         Split options into keys and values in cli_parse() and save them to
+//         Cli.program_option_views and Cli.cmd_option_views. Unless CLI_NOHEAP
+//         is defined, views take one more allocation.
+//     CLI_INDEX
+//         Build hash tables of program and command options in cli_parse(), so
+//         cli_get_option() and cli_get_cmd_option() take constant time.
+//         Implies CLI_OPTION_VIEWS and shares the allocation with them.
+//     CLI_ENV_PREFIX
+//         If defined (e.g. as "APP_"), environment variables with this prefix
+//         are indexed in cli_parse() and used by cli_get_option() (and for
+//         fields of CLI_OPTIONS) for program options that are not specified on
+//         the command line. Implies CLI_INDEX and cannot be used with
+//         CLI_NOHEAP.
+//     CLI_CONFIG_FILES
+//         Provide cli_load_config() that maps a file of `key = value` lines
+//         and uses it for program options (and fields of CLI_OPTIONS) that are
+//         not specified otherwise. Implies CLI_INDEX. POSIX is required, and
+//         it cannot be used with CLI_NOHEAP.
+//     CLI_RESPONSE_FILES
+//         Replace `@path` arguments with tokens of the file at `path` in
+//         cli_parse(). Files are mapped with mmap() and split in place, so
+//         POSIX is required. Cannot be used with CLI_NOHEAP.
+//     CLI_NO_SIMD
+//         Do not use SSE2, AVX2 or NEON for splitting strings into tokens,
+//         even if the compiler targets them.
+//     CLI_FLAGS
+//         Expand single-character flags (`-v`, `-abc`) into bitsets in
+//         cli_parse(), so cli_flag() and cli_cmd_flag() are single bit tests.
+//         With CLI_OPTIONS, clusters of aliases of FLAG and COUNT options
+//         (`-vv`) set their fields as well.
+//     CLI_OPTIONS(X)
+//         A schema of program options. For more information, see below.
+//         Implies CLI_OPTION_VIEWS.
+//     CLI_OPTIONS_HELP(X)
+//         Descriptions of program options for cli_print_help(). Each entry is
+//         X(name, "description"), and options without one are listed anyway.
+//     CLI_USAGE
+//         If defined (e.g. as "app [options] <file>"), cli_print_help() starts
+//         with this usage line.
+//     CLI_COMMANDS(X)
+//         A table of subcommands. For more information, see below.
+//     CLI_PROGRESS
+//         Provide CliProgress, a status line that is redrawn at most a given
+//         number of times per second. POSIX is required.
+//     CLI_STATS
+//         Count allocations made for every Cli. For more information, see
+//         cli_stats().
+//     CLI_CPP
+//         Provide cli::Parser and cli::Tokens for C++17: buckets as ranges of
+//         std::string_view and typed options (e.g. get<int>("threads")). For
+//         more information, see the end of the file.
+//     CLI_TIMERS
+//         Provide CLI_TIME_BEGIN() and CLI_TIME_END() that measure scopes and
+//         print their statistics at exit. They compile to nothing unless
+//         CLI_LOG_LEVEL allows debug messages. POSIX is required.
 //
+//     CLI_SIZE_T = size_t
+//         An unsigned type for lengths and capacities of arrays (e.g.
+//         CliArray).
 //     CLI_DEFAULT_ARR_CAP = 5
 //         Default capacity for dynamic arrays (e.g. CliArray).
+//     CLI_LOG_LEVEL = CLI_LOG_DEBUG
+//         The minimum level of printed messages: CLI_LOG_DEBUG, CLI_LOG_INFO,
+//         CLI_LOG_ERROR or CLI_LOG_NONE. Calls of printing macros below it are
+//         removed, including evaluation of their arguments.
+//     CLI_OUTPUT_BUFFER_SIZE
+//         If defined, printing macros append messages to a buffer of this many
+//         bytes, which is written with a single call when it is full, when
+//         an error message is printed or when cli_flush() is called.
+//     CLI_OUTPUT_THREADS
+//         Make printing macros thread-safe. Each thread formats messages into
+//         a thread-local buffer and publishes complete lines to a lock-free
+//         ring, which is written by cli_flush(). Implies CLI_OUTPUT_BUFFER_SIZE
+//         (4096 by default).
+//     CLI_OUTPUT_LINE_SIZE = 256
+//         The maximum length of a line with CLI_OUTPUT_THREADS. Longer lines
+//         are truncated.
+//     CLI_OUTPUT_RING_SIZE = 256
+//         The number of lines that the ring of CLI_OUTPUT_THREADS can hold.
+//         Must be a power of two. If the ring is full, threads flush it (or
+//         wait for the thread that flushes it).
 //     CLI_ASSERT = assert
 //         An assert function. If not defined, assert() from <assert.h> is
 //         used.
@@ -83,6 +166,8 @@
 //         // ...
 //         if (--color == "yes") {
 //             cli_toggle_styles();
+//         } else if (--color == "auto") {
+//             cli_detect_styles();
 //         }
 //         // ...
 //     }
@@ -97,18 +182,80 @@
 // does not affect the behaviour.
 //
 // Changes that have to be made to your program:
-// 1. Declare an array for arguments: CliStackNode stack[argc - 1]
+// 1. Declare an array for arguments: const char* stack[CLI_STACK_SIZE(argc)]
 // 2. Call cli_parse_noheap(argc, argv, &cli, stack) instead of cli_parse(...)
 // 3. If no heap allocations are made, it is not possible for cli.h to
 //    determine the capacity of the CliStackNode[] array. Thus, .capacity
 //    of CliArray should not be used.
-// 4. If you use cli_parse_noheap() instead of preparing variables manually,
-//    .next_unused of CliStackNode cannot be used either. It points to a local
-//    variable that becomes invalid after cli_parse_noheap() returns.
+// 4. Each array takes a contiguous region of the stack: program options come
+//    first, then arguments, then command options. Thus, .data of an array
+//    stays valid as long as the stack does.
+
+// Program options can be declared with the CLI_OPTIONS X-macro. Each entry is
+// X(name, alias, kind, default_value), where `alias` is a character for the
+// short form (or 0) and `kind` is one of:
+//     FLAG      An option without a value, stored as `int`.
+//     INT       An integer, stored as `long long`.
+//     UINT      A non-negative integer, stored as `unsigned long long`.
+//     FLOAT     A decimal number, stored as `double`.
+//     SIZE      A number of bytes with an optional K/M/G/T suffix, stored as
+//               `unsigned long long`.
+//     DURATION  A number of milliseconds with an optional ms/s/m/h unit, stored
+//               as `unsigned long long`.
+//     STRING    An option with a value, stored as `const char*`.
+//     COUNT     An option without a value that counts how many times it is
+//               specified (`-v -v -v`), stored as `int`.
+//     LIST      An option with a value that collects all of its values
+//               (`-I=a -I=b`), stored as `struct CliList`. `default_value` is
+//               ignored, as a list is empty by default.
+//
+// Options of other kinds keep the last value if they are specified several
+// times.
+//
+//     #define CLI_OPTIONS(X) X(verbose, 'v', FLAG, 0) X(threads, 't', INT, 4)
+//
+// cli_parse() then converts program options (`--threads=8`, `-t=8`, `-v`) to
+// fields of Cli.options and fails on unknown ones. After two dashes, a name can
+// be abbreviated to a unique prefix (`--verb`), while ambiguous prefixes are
+// reported as errors. Names are sorted on the first call of cli_parse(), so
+// every option takes two binary searches. (Without GCC or Clang, the first
+// call has to be made before other threads parse.)
+//
+// cli_print_help() lists the schema with descriptions from CLI_OPTIONS_HELP:
+//
+//     #define CLI_OPTIONS_HELP(X) X(threads, "The number of workers.")
+//
+//     Options:
+//       -v, --verbose
+//       -t, --threads=INT  The number of workers. (default: 4)
+
+// Subcommands can be declared with the CLI_COMMANDS X-macro. Each entry is
+// X(name, path), where `path` consists of words separated by single spaces:
+//
+//     #define CLI_COMMANDS(X) X(remote, "remote") X(remote_add, "remote add")
+//
+// cli_parse() matches leading positional arguments against paths word by word
+// and saves the longest matching command to Cli.command, e.g.
+// CliCommandId_remote_add for `remote add origin`. Words of the command are
+// not stored in Cli.args, and options after them are command options. Every
+// word can be abbreviated to a unique prefix (`rem a`), while ambiguous
+// prefixes are reported as errors.
+//
+// Paths are sorted on the first call of cli_parse(), so matching a word is a
+// binary search over the commands that share the previous words. (Without GCC
+// or Clang, the first call has to be made before other threads parse.)
 
 #ifndef __CLI_H_
 #define __CLI_H_
 
+// The implementation uses POSIX functions (e.g. mmap() and clock_gettime())
+// that strict modes (e.g. -std=c99) hide, so it requests them before the first
+// system header. If a system header is included before cli.h, the program has
+// to define _DEFAULT_SOURCE or _POSIX_C_SOURCE (200809L) itself.
+#if defined(CLI_IMPLEMENTATION) && !defined(_DEFAULT_SOURCE)
+#define _DEFAULT_SOURCE
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -117,37 +264,294 @@ extern "C" {
 #define CLI_NOHEAP
 #endif
 
-const char* CLI_RESET = "";
-const char* CLI_BOLD = "";
-const char* CLI_DIM = "";
-const char* CLI_FORE_RED = "";
-const char* CLI_FORE_BRBLUE = "";
+// Escape sequences for formatting output to a stream. All of them are empty
+// strings if styles are disabled.
+struct CliStyle {
+    const char* reset;
+    const char* bold;
+    const char* dim;
+    const char* fore_red;
+    const char* fore_brblue;
+    // Whether the stream is a terminal (set by cli_detect_styles()).
+    int terminal;
+};
+
+// Styles of stderr (printing macros and CliProgress) and stdout
+// (cli_print_help()).
+extern struct CliStyle cli_stderr_style;
+extern struct CliStyle cli_stdout_style;
+
+// Styles of stderr.
+#define CLI_RESET       (cli_stderr_style.reset)
+#define CLI_BOLD        (cli_stderr_style.bold)
+#define CLI_DIM         (cli_stderr_style.dim)
+#define CLI_FORE_RED    (cli_stderr_style.fore_red)
+#define CLI_FORE_BRBLUE (cli_stderr_style.fore_brblue)
+
+#if defined(CLI_ARENA) && defined(CLI_NOHEAP)
+#undef CLI_ARENA
+#endif
+
+#if defined(CLI_RESPONSE_FILES) && defined(CLI_NOHEAP)
+#error "CLI_RESPONSE_FILES cannot be used with CLI_NOHEAP."
+#endif
+
+#if defined(CLI_ENV_PREFIX) && defined(CLI_NOHEAP)
+#error "CLI_ENV_PREFIX cannot be used with CLI_NOHEAP."
+#endif
+
+#if defined(CLI_CONFIG_FILES) && defined(CLI_NOHEAP)
+#error "CLI_CONFIG_FILES cannot be used with CLI_NOHEAP."
+#endif
+
+#if (defined(CLI_ENV_PREFIX) || defined(CLI_CONFIG_FILES)) && !defined(CLI_INDEX)
+#define CLI_INDEX
+#endif
+
+#ifndef CLI_SIZE_T
+#include <stddef.h>
+#define CLI_SIZE_T size_t
+#endif
+
+// The largest value of CLI_SIZE_T (which must be unsigned).
+#define CLI_SIZE_MAX ((CLI_SIZE_T)-1)
 
 #ifdef CLI_NOHEAP
 struct CliArray {
-    unsigned short length;
+    CLI_SIZE_T length;
+    // The stack shared by all arrays and given to cli_parse_noheap().
     const char** stack;
     const char** data;
-    // A pointer to a global (between `CliArray` instances) variable that points
-    // to a next unused `stack` item.
-    //
-    // Techinally speaking, it's a pointer to a pointer to an argument
-    // (`const char*`).
-    const char*** next_unused;
 };
 #else
 struct CliArray {
-    unsigned short length;
-    unsigned short capacity;
+    CLI_SIZE_T length;
+    CLI_SIZE_T capacity;
     const char** data;
 };
 #endif // CLI_NOHEAP
 
+#if (defined(CLI_INDEX) || defined(CLI_OPTIONS)) && !defined(CLI_OPTION_VIEWS)
+#define CLI_OPTION_VIEWS
+#endif
+
+#ifdef CLI_OPTION_VIEWS
+// An option split into parts, e.g. `--key=value`.
+struct CliOption {
+    // The number of leading dashes.
+    CLI_SIZE_T dashes;
+    // The key without leading dashes. It is not NUL-terminated.
+    const char* key;
+    CLI_SIZE_T key_length;
+    // The value after `=` or NULL if there is no value.
+    const char* value;
+};
+
+// The number of `const char*` items that a single CliOption occupies.
+#define CLI_OPTION_ITEMS \
+    ((sizeof(struct CliOption) + sizeof(const char*) - 1) / sizeof(const char*))
+#endif // CLI_OPTION_VIEWS
+
+#ifdef CLI_INDEX
+// An open addressing hash table of options, keyed by `CliOption.key`.
+struct CliIndex {
+    CLI_SIZE_T capacity;
+    // NULL for empty slots.
+    const struct CliOption** slots;
+};
+#endif // CLI_INDEX
+
+#ifdef CLI_OPTIONS
+// The number of `const char*` items that LIST options take per option.
+#define CLI_OPTION_LIST_ITEMS (CliOptionListCount ? 2 : 0)
+#else
+#define CLI_OPTION_LIST_ITEMS 0
+#endif
+
+// The number of `const char*` items required by cli_parse_noheap().
+#if defined(CLI_INDEX)
+#define CLI_STACK_SIZE(argc) ((argc) * (3 + CLI_OPTION_ITEMS + CLI_OPTION_LIST_ITEMS))
+#elif defined(CLI_OPTION_VIEWS)
+#define CLI_STACK_SIZE(argc) ((argc) * (1 + CLI_OPTION_ITEMS + CLI_OPTION_LIST_ITEMS))
+#else
+#define CLI_STACK_SIZE(argc) (argc)
+#endif
+
+#ifdef CLI_OPTIONS
+// Types of fields in CliOptions for every kind of options.
+#define CLI_FLAG_TYPE     int
+#define CLI_INT_TYPE      long long
+#define CLI_UINT_TYPE     unsigned long long
+#define CLI_FLOAT_TYPE    double
+#define CLI_SIZE_TYPE     unsigned long long
+#define CLI_DURATION_TYPE unsigned long long
+#define CLI_STRING_TYPE   const char*
+#define CLI_COUNT_TYPE    int
+#define CLI_LIST_TYPE     struct CliList
+
+// Only LIST options keep every value.
+#define CLI_FLAG_IS_LIST     0
+#define CLI_INT_IS_LIST      0
+#define CLI_UINT_IS_LIST     0
+#define CLI_FLOAT_IS_LIST    0
+#define CLI_SIZE_IS_LIST     0
+#define CLI_DURATION_IS_LIST 0
+#define CLI_STRING_IS_LIST   0
+#define CLI_COUNT_IS_LIST    0
+#define CLI_LIST_IS_LIST     1
+
+#define CLI_X_ID(name, alias, kind, default_value)    CliOptionId_##name,
+#define CLI_X_FIELD(name, alias, kind, default_value) CLI_##kind##_TYPE name;
+#define CLI_X_LIST(name, alias, kind, default_value)  +CLI_##kind##_IS_LIST
+
+// Values of a LIST option in order. They are stored in the same block as
+// views of options, so `data` is valid until the next parse or cli_free().
+struct CliList {
+    const char** data;
+    CLI_SIZE_T length;
+};
+
+enum CliOptionId {
+    CLI_OPTIONS(CLI_X_ID)
+    CliOptionIdCount
+};
+
+// The number of LIST options in the schema.
+enum { CliOptionListCount = 0 CLI_OPTIONS(CLI_X_LIST) };
+
+// Values of program options, declared with CLI_OPTIONS.
+struct CliOptions {
+    CLI_OPTIONS(CLI_X_FIELD)
+};
+
+// Layers that fields of CliOptions are set from, in order of precedence.
+enum CliLayer {
+    CliLayerDefault,
+    CliLayerConfig,
+    CliLayerEnv,
+    CliLayerArgv,
+};
+
+#undef CLI_X_ID
+#undef CLI_X_FIELD
+#undef CLI_X_LIST
+#endif // CLI_OPTIONS
+
+#ifdef CLI_COMMANDS
+#define CLI_X_COMMAND_ID(name, path) CliCommandId_##name,
+
+// Commands declared with CLI_COMMANDS. CliCommandIdNone is used if the command
+// line does not start with a command.
+enum CliCommandId {
+    CliCommandIdNone,
+    CLI_COMMANDS(CLI_X_COMMAND_ID)
+    CliCommandIdCount
+};
+
+#undef CLI_X_COMMAND_ID
+#endif // CLI_COMMANDS
+
+#ifdef CLI_RESPONSE_FILES
+// A memory-mapped response file.
+struct CliResponseFile {
+    // NUL-terminated tokens, one after another.
+    char* data;
+    // The size of the mapping.
+    size_t size;
+    // The number of tokens.
+    CLI_SIZE_T length;
+};
+#endif // CLI_RESPONSE_FILES
+
+#ifdef CLI_CONFIG_FILES
+// A memory-mapped config file.
+struct CliConfigFile {
+    char* data;
+    // The size of the mapping.
+    size_t size;
+    // Entries of the file, which point into `data`, and a table of them in the
+    // same block of `capacity` views (one per line).
+    struct CliOption* views;
+    CLI_SIZE_T length;
+    CLI_SIZE_T capacity;
+    struct CliIndex index;
+};
+#endif // CLI_CONFIG_FILES
+
+#ifdef CLI_STATS
+// Statistics of memory that is allocated for a `Cli`.
+struct CliStats {
+    // The number of successful calls of CLI_MALLOC and CLI_REALLOC (calls of
+    // CLI_REALLOC for NULL are allocations).
+    size_t allocations;
+    size_t reallocations;
+    // The total number of bytes requested by these calls.
+    size_t bytes;
+    // The number of bytes in blocks that are held now and at most.
+    size_t current;
+    size_t peak;
+};
+#endif
+
 typedef struct Cli {
     const char* execfile;
     struct CliArray args;
     struct CliArray cmd_options;
     struct CliArray program_options;
+#ifdef CLI_ARENA
+    // A single block that holds `data` of all arrays above.
+    const char** arena;
+    CLI_SIZE_T arena_capacity;
+#endif
+#ifdef CLI_OPTION_VIEWS
+    // Split options, in the same order as `cmd_options` and `program_options`.
+    struct CliOption* cmd_option_views;
+    struct CliOption* program_option_views;
+#ifndef CLI_NOHEAP
+    // The number of options that the block of views (and tables) can hold.
+    CLI_SIZE_T option_views_capacity;
+#endif
+#endif
+#ifdef CLI_INDEX
+    struct CliIndex cmd_index;
+    struct CliIndex program_index;
+#endif
+#ifdef CLI_ENV_PREFIX
+    // Environment variables with the prefix, which point into `environ`, and
+    // a table of them in the same block.
+    struct CliOption* env_views;
+    CLI_SIZE_T env_capacity;
+    struct CliIndex env_index;
+#endif
+#ifdef CLI_OPTIONS
+    struct CliOptions options;
+    // The option (or the environment variable) that set each field of
+    // `options`, NULL for defaults, and its layer.
+    const struct CliOption* option_sources[CliOptionIdCount];
+    unsigned char option_layers[CliOptionIdCount];
+#endif
+#ifdef CLI_COMMANDS
+    // Words of the command are not stored in `args`.
+    enum CliCommandId command;
+#endif
+#ifdef CLI_RESPONSE_FILES
+    struct CliResponseFile* response_files;
+    CLI_SIZE_T response_files_length;
+#endif
+#ifdef CLI_CONFIG_FILES
+    // Loaded by cli_load_config(), in order.
+    struct CliConfigFile* config_files;
+    CLI_SIZE_T config_files_length;
+#endif
+#ifdef CLI_FLAGS
+    // Bitsets of single-character flags, indexed by characters.
+    unsigned long long cmd_flags[4];
+    unsigned long long program_flags[4];
+#endif
+#ifdef CLI_STATS
+    // Use cli_stats() instead, as `current` and `peak` are updated lazily.
+    struct CliStats stats;
+#endif
 } Cli;
 
 enum CliError {
@@ -156,16 +560,77 @@ enum CliError {
     CliErrorFatal
 };
 
-/* Initialize variables for formatting output.
+// Kinds of tokens on the command line. Values are used as indexes, thus the
+// order matters.
+enum CliToken {
+    CliTokenArgument,
+    CliTokenCmdOption,
+    CliTokenProgramOption,
+    CliTokenDoubleDash
+};
+
+// A function that receives tokens from cli_parse_each().
+typedef enum CliError (*CliCallback)(enum CliToken kind, const char* token, void* userdata);
+
+/* Enable (if `enabled` is non-zero) or disable styles of `style`.
+ *
+ * If `CLI_NO_STYLES` is defined, does nothing.
+ */
+void cli_set_styles(struct CliStyle* style, int enabled);
+
+/* Toggle styles of both stderr and stdout.
  *
- * If `CLI_RESET` contains an empty string, all variables are initalized with
- * escape sequences, according to their names.
- * Otherwise, variables are initalized with empty strings.
+ * If `CLI_RESET` (of stderr) contains an empty string, all styles are
+ * initalized with escape sequences, according to their names.
+ * Otherwise, styles are initalized with empty strings.
  *
  * If `CLI_NO_STYLES` is defined, does nothing.
  */
 void cli_toggle_styles(void);
 
+/*
+ * Enable styles of stderr and stdout if they are terminals, unless the
+ * `NO_COLOR` environment variable is not empty or `TERM` is "dumb".
+ *
+ * Checks are made once and saved to cli_stderr_style and cli_stdout_style,
+ * so printing never queries the terminal. Without POSIX isatty(), streams are
+ * not considered terminals.
+ *
+ * If `CLI_NO_STYLES` is defined, does nothing.
+ */
+void cli_detect_styles(void);
+
+// Levels of messages. cli_printf_debug() is CLI_LOG_DEBUG,
+// cli_print_info() and cli_printf_info() are CLI_LOG_INFO, and so on.
+#define CLI_LOG_DEBUG 0
+#define CLI_LOG_INFO  1
+#define CLI_LOG_ERROR 2
+#define CLI_LOG_NONE  3
+
+#ifndef CLI_LOG_LEVEL
+#define CLI_LOG_LEVEL CLI_LOG_DEBUG
+#endif
+
+/*
+ * The minimum level of printed messages, which can be changed at runtime
+ * (e.g. to CLI_LOG_ERROR for `-q`). It is checked before formatting.
+ *
+ * Messages below `CLI_LOG_LEVEL` are never printed regardless of it.
+ */
+extern int cli_log_level;
+
+/*
+ * Write messages buffered by printing macros.
+ *
+ * The buffer is also flushed when it is full, after error messages and at
+ * exit. If `CLI_OUTPUT_BUFFER_SIZE` is not defined, does nothing.
+ *
+ * If `CLI_OUTPUT_THREADS` is defined, lines are taken from the ring, and only
+ * one thread flushes at a time: if the ring is being flushed by another
+ * thread, returns immediately. A dedicated thread may call it periodically.
+ */
+void cli_flush(void);
+
 /*
  * Parse the command line and save results to `cli`.
  *
@@ -174,6 +639,159 @@ void cli_toggle_styles(void);
  */
 enum CliError cli_parse(int argc, char** argv, Cli* cli);
 
+#ifndef CLI_NOHEAP
+/*
+ * Parse the command line and save results to `cli`, allocating arrays of the
+ * exact size.
+ *
+ * The command line is traversed twice: the first pass counts tokens of each
+ * kind, the second one stores them. Thus, no reallocations are made.
+ *
+ * If `CLI_ARENA` is defined, the same as cli_parse().
+ */
+enum CliError cli_parse_exact(int argc, char** argv, Cli* cli);
+
+/*
+ * Parse the command line and save results to `cli`, reusing its memory.
+ *
+ * `cli` should be either zero-initialized or previously filled by one of the
+ * parsing functions. Buffers that are large enough are kept, so once they have
+ * grown to fit the typical command line, parsing makes no allocations.
+ * The memory is still owned by `cli` and should be released by cli_free().
+ */
+enum CliError cli_parse_into(int argc, char** argv, Cli* cli);
+
+/*
+ * Split `line` into tokens in place and parse them as a command line, reusing
+ * memory of `cli` like cli_parse_into().
+ *
+ * Tokens are separated by whitespace. Single quotes preserve everything up to
+ * the closing quote, while a backslash escapes the next character outside of
+ * quotes and within double quotes. A quote that is not closed is reported as
+ * CliErrorUser. `line` should not contain the executable file (`Cli.execfile`
+ * is set to NULL) and should be kept while `cli` is used.
+ */
+enum CliError cli_parse_line(char* line, Cli* cli);
+#endif
+
+/*
+ * Make `cli` empty, keeping its buffers and their capacities.
+ *
+ * Lengths of arrays are set to 0, so pointers into `cli` should not be used
+ * anymore. If `CLI_RESPONSE_FILES` is defined, response files are unmapped.
+ */
+void cli_reset(Cli* cli);
+
+/*
+ * Classify the command line and pass every token to `callback` in order,
+ * without storing anything.
+ *
+ * Tokens are classified by the same rules as in cli_parse(), but `--`
+ * and the executable file are not passed. Commands of `CLI_COMMANDS` are not
+ * matched, so their words are passed as positional arguments. If
+ * `CLI_RESPONSE_FILES` is defined, response files are mapped one at a time and
+ * their tokens are valid only during the call of `callback`.
+ *
+ * Stops at the first error of classification or the first non-zero value
+ * returned by `callback`, and returns it.
+ */
+enum CliError cli_parse_each(int argc, char** argv, CliCallback callback, void* userdata);
+
+#ifdef CLI_INDEX
+/*
+ * Get a value of the program option `key`, e.g. `value` for `--key=value`.
+ *
+ * Leading dashes are ignored both in `key` and in options, so "key" matches
+ * `-key` and `--key`. If the option is specified several times, the last one
+ * is used.
+ *
+ * Layers are used in order of precedence: the command line, then the
+ * environment variable with CLI_ENV_PREFIX (if it is defined), whose name is
+ * compared ignoring case and treating `-` as `_`, so "dry-run" matches
+ * `APP_DRY_RUN`. If `CLI_CONFIG_FILES` is defined, config files are used
+ * after that.
+ *
+ * If `CLI_OPTIONS` is defined, options of the schema are resolved by their
+ * names or aliases ("t" and "threads" find `-t=8`, `--thr=8` and
+ * `APP_THREADS=8`), and the layer that set the field of Cli.options is used.
+ * Other keys are compared literally.
+ *
+ * Returns an empty string if the option has no value, and NULL if the option
+ * is not specified.
+ */
+const char* cli_get_option(const Cli* cli, const char* key);
+
+/* Same as cli_get_option(), but for command options. */
+const char* cli_get_cmd_option(const Cli* cli, const char* key);
+
+#define cli_has_flag(cli, key) (cli_get_option((cli), (key)) != NULL)
+
+/*
+ * Convert a value of the program option `key` and save it to `result`.
+ *
+ * Values are converted without relying on the locale and without allocations.
+ * Sizes accept K, M, G and T suffixes (powers of 1024, e.g. `64K`), durations
+ * are in milliseconds and accept ms, s, m and h units (e.g. `5s`).
+ *
+ * If the option is not specified, `result` is left untouched, so it can hold
+ * a default value. Invalid values are reported with cli_printf_error() and
+ * CliErrorUser is returned.
+ */
+enum CliError cli_get_i64(const Cli* cli, const char* key, long long* result);
+enum CliError cli_get_u64(const Cli* cli, const char* key, unsigned long long* result);
+enum CliError cli_get_f64(const Cli* cli, const char* key, double* result);
+enum CliError cli_get_size(const Cli* cli, const char* key, unsigned long long* result);
+enum CliError cli_get_duration(const Cli* cli, const char* key, unsigned long long* result);
+#endif // CLI_INDEX
+
+#ifdef CLI_CONFIG_FILES
+/*
+ * Map the config file at `path` and use its entries for program options that
+ * are specified neither on the command line nor in the environment. Files
+ * loaded later take precedence over earlier ones.
+ *
+ * If `CLI_OPTIONS` is defined, entries with full names of options are stored
+ * to fields of Cli.options that are not set by these layers, so this function
+ * should be called after cli_parse(). FLAG options take a boolean
+ * (`verbose = yes`), COUNT options a number and LIST options a single value.
+ *
+ * Every line is `key = value`, where whitespace around `=` is ignored and the
+ * value is a single token that is unquoted like tokens of response files
+ * (e.g. `name = "John Smith"`). Empty lines and lines starting with `#` or `;`
+ * are skipped. Sections of INI files are not supported.
+ *
+ * The file is split in place and indexed in one pass, making one allocation
+ * for all entries. Other values are converted only when they are looked up.
+ * Files are unloaded by the next parse of `cli` and by cli_free(), so this
+ * function should be called after parsing.
+ */
+enum CliError cli_load_config(Cli* cli, const char* path);
+#endif
+
+#ifdef CLI_OPTIONS
+/*
+ * Print help text of CLI_OPTIONS (and CLI_USAGE) to stdout.
+ *
+ * The text is formatted once for the current styles of stdout (see
+ * cli_stdout_style) into a static buffer, so it is written with a single
+ * fwrite().
+ */
+void cli_print_help(void);
+#endif
+
+#ifdef CLI_FLAGS
+/*
+ * Check whether the single-character program flag `c` is specified, either
+ * alone (`-c`) or in a cluster (`-abc`).
+ */
+#define cli_flag(cli, c) \
+    ((int)(((cli)->program_flags[(unsigned char)(c) >> 6] >> ((unsigned char)(c) & 63)) & 1))
+
+/* Same as cli_flag(), but for command flags. */
+#define cli_cmd_flag(cli, c) \
+    ((int)(((cli)->cmd_flags[(unsigned char)(c) >> 6] >> ((unsigned char)(c) & 63)) & 1))
+#endif // CLI_FLAGS
+
 #ifdef CLI_NOHEAP
 /*
  * Parse the command line and save pointers to `stack` elements to `cli`.
@@ -184,7 +802,91 @@ enum CliError cli_parse(int argc, char** argv, Cli* cli);
 enum CliError cli_parse_noheap(int argc, char** argv, struct Cli* cli, const char** stack);
 #endif
 
+#ifdef CLI_PROGRESS
+// A counter of processed items that is reported with a status line.
+//
+// Fields are updated by cli_progress_add() and should not be changed.
+struct CliProgress {
+    const char* title;
+    // The expected count or 0 if it is unknown.
+    unsigned long long total;
+    unsigned long long count;
+    // The time is checked only when `count` reaches `check_at`.
+    unsigned long long check_at;
+    unsigned long long step;
+    // The count and the time (in nanoseconds) of the last redraw.
+    unsigned long long drawn_count;
+    unsigned long long drawn_at;
+    unsigned long long interval;
+    int drawing;
+    // Whether the line is redrawn in place (with styles and a terminal).
+    int in_place;
+};
+
+/*
+ * Start reporting progress of `total` items (or 0 if unknown) at most `rate`
+ * times per second.
+ *
+ * If styles are enabled and stderr is a terminal (as detected by
+ * cli_detect_styles()), a single line is redrawn with '\r'. Otherwise, a new
+ * line is printed every time.
+ */
+void cli_progress_begin(
+    struct CliProgress* progress, const char* title, unsigned long long total, unsigned rate
+);
+
+// Redraw the status line if it is time to. Used by cli_progress_add().
+void cli_progress_check(struct CliProgress* progress);
+
+/*
+ * Add `n` processed items. It is safe to call from several threads.
+ *
+ * Usually, it is a single atomic increment and a comparison, as the time is
+ * checked only after a number of items estimated from the last redraw. Before
+ * the first redraw, the number starts at 16 and doubles on every check.
+ */
+static inline void cli_progress_add(struct CliProgress* progress, unsigned long long n) {
+    unsigned long long count = __atomic_add_fetch(&progress->count, n, __ATOMIC_RELAXED);
+    if (count >= __atomic_load_n(&progress->check_at, __ATOMIC_RELAXED)) {
+        cli_progress_check(progress);
+    }
+}
+
+/* Draw the final state of `progress` and end the status line. */
+void cli_progress_end(struct CliProgress* progress);
+#endif // CLI_PROGRESS
+
+#ifdef CLI_STATS
+/*
+ * Get statistics of allocations made for `cli` since cli_parse() (or
+ * cli_parse_exact()), including calls of cli_parse_into() and
+ * cli_parse_line() that reuse it.
+ *
+ * Memory of mapped response files is not counted. This function should be
+ * called before cli_free().
+ */
+struct CliStats cli_stats(const Cli* cli);
+
+/* Print statistics of `cli` with cli_printf_info(). */
+void cli_print_stats(const Cli* cli);
+#endif
+
+#ifdef CLI_TIMERS
+/*
+ * Print statistics of all scopes measured by CLI_TIME_BEGIN() and
+ * CLI_TIME_END() with cli_printf_debug().
+ *
+ * It is also called at exit.
+ */
+void cli_time_report(void);
+#endif
+
 /* Free memory occupied by dynamic arrays.
+ *
+ * If `CLI_ARENA` is defined, frees the only block allocated by cli_parse().
+ * If `CLI_OPTION_VIEWS` is defined, views (and tables) of options are freed as
+ * well. If `CLI_RESPONSE_FILES` is defined, response files are unmapped. If
+ * `CLI_ENV_PREFIX` is defined, the snapshot of environment variables is freed.
  *
  * If either `CLI_NOHEAP` or `CLI_NOHEAP_IMPLEMENTATION` is defined, does
  * nothing.
@@ -198,8 +900,15 @@ void cli_free(Cli* cli);
 #define CLI_STR_(x) #x
 #define CLI_STR(x)  CLI_STR_(x)
 
-// Cannot be equal to 0. Otherwise, memory checks will be failed.
-#define CLI_INVALID_PTR (const char**)0xCA10CAFE
+// Zero values of structures. C++ has no compound literals, and it warns about
+// missing initializers in `{ 0 }`.
+#ifdef __cplusplus
+#define CLI_ZERO                 {}
+#define CLI_ZERO_LITERAL(type)   {}
+#else
+#define CLI_ZERO                 { 0 }
+#define CLI_ZERO_LITERAL(type)   (type) { 0 }
+#endif
 
 #ifdef CLI_NO_STDBOOL_H
 typedef unsigned char bool
@@ -213,6 +922,91 @@ typedef unsigned char bool
 #include <stdio.h>
 #endif
 
+#ifndef CLI_NOHEAP
+// Used by cli_parse_line() and response files.
+#define CLI_TOKENIZER
+#endif
+
+#if defined(CLI_OPTION_VIEWS) || defined(CLI_TOKENIZER) || defined(CLI_OUTPUT_THREADS) \
+    || defined(CLI_COMMANDS) || !defined(CLI_NO_STYLES)
+#include <string.h>
+#endif
+
+#ifndef CLI_NO_STYLES
+// getenv() is used by cli_detect_styles().
+#include <stdlib.h>
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#define CLI_ISATTY
+#endif
+#endif // CLI_NO_STYLES
+
+#if defined(CLI_TOKENIZER) && !defined(CLI_NO_SIMD)
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define CLI_SIMD_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CLI_SIMD_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define CLI_SIMD_NEON
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define CLI_CTZ(x)   __builtin_ctz(x)
+#define CLI_CTZLL(x) __builtin_ctzll(x)
+#else
+static int cli_ctzll(unsigned long long x) {
+    int n = 0;
+    for (; !(x & 1); x >>= 1) n++;
+    return n;
+}
+#define CLI_CTZ(x)   cli_ctzll(x)
+#define CLI_CTZLL(x) cli_ctzll(x)
+#endif
+#endif // CLI_TOKENIZER && !CLI_NO_SIMD
+
+#ifdef CLI_ENV_PREFIX
+extern char** environ;
+#endif
+
+#if defined(CLI_RESPONSE_FILES) || defined(CLI_CONFIG_FILES)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#endif // CLI_RESPONSE_FILES || CLI_CONFIG_FILES
+
+#if defined(CLI_OUTPUT_BUFFER_SIZE) || defined(CLI_OUTPUT_THREADS)
+// atexit() is used to flush the buffer.
+#include <stdlib.h>
+#endif
+
+#ifdef CLI_OUTPUT_THREADS
+// Threads yield while the ring is full and flushed by another thread.
+#if defined(__unix__) || defined(__APPLE__)
+#include <sched.h>
+#define CLI_OUTPUT_YIELD() sched_yield()
+#else
+#define CLI_OUTPUT_YIELD() ((void)0)
+#endif
+#endif
+
+#ifdef CLI_PROGRESS
+#include <time.h>
+#endif
+
+#ifdef CLI_TIMERS
+// atexit() is used to print the report.
+#include <stdlib.h>
+#include <time.h>
+#endif
+
 #ifndef CLI_NOHEAP
 #if !defined CLI_MALLOC || !defined CLI_REALLOC || !defined CLI_FREE
 #include <stdlib.h>
@@ -231,6 +1025,17 @@ typedef unsigned char bool
 #define CLI_FREE free
 #endif
 
+#ifdef CLI_STATS
+// Count a call of CLI_MALLOC or CLI_REALLOC that requested `size` bytes if it
+// returned a block (`result`). Reallocations of NULL (`old`) are allocations.
+#define cli_stats_add(cli, old, result, size)                                      \
+    ((void)((result)                                                               \
+            && ((old) ? (cli)->stats.reallocations++ : (cli)->stats.allocations++, \
+                (cli)->stats.bytes += (size))))
+#else
+#define cli_stats_add(cli, old, result, size) ((void)(old), (void)(result))
+#endif
+
 #ifndef CLI_ASSERT
 #include <assert.h>
 #define CLI_ASSERT assert
@@ -248,195 +1053,2556 @@ typedef unsigned char bool
 #define CLI_INFO_SYM "●"
 #endif
 
-#ifndef cli_print_error
-#define cli_print_error(title, msg)                                                        \
-    fprintf(                                                                               \
-        stderr, "%s" CLI_ERROR_SYM "%s%s " title "%s: " msg "\n", CLI_FORE_RED, CLI_RESET, \
-        CLI_BOLD, CLI_RESET                                                                \
-    )
+#ifdef CLI_OUTPUT_THREADS
+#ifndef CLI_OUTPUT_BUFFER_SIZE
+#define CLI_OUTPUT_BUFFER_SIZE 4096
 #endif
-
-#ifndef cli_printf_error
-#define cli_printf_error(title, msg, ...)                                                  \
-    fprintf(                                                                               \
-        stderr, "%s" CLI_ERROR_SYM "%s%s " title "%s: " msg "\n", CLI_FORE_RED, CLI_RESET, \
-        CLI_BOLD, CLI_RESET, __VA_ARGS__                                                   \
-    )
+#ifndef CLI_OUTPUT_LINE_SIZE
+#define CLI_OUTPUT_LINE_SIZE 256
 #endif
-
-#ifndef cli_print_info
-#define cli_print_info(title, msg)                                                           \
-    fprintf(                                                                                 \
-        stderr, "%s" CLI_INFO_SYM "%s%s " title "%s: " msg "\n", CLI_FORE_BRBLUE, CLI_RESET, \
-        CLI_BOLD, CLI_RESET                                                                  \
-    )
+#ifndef CLI_OUTPUT_RING_SIZE
+#define CLI_OUTPUT_RING_SIZE 256
 #endif
-
-#ifndef cli_printf_info
-#define cli_printf_info(title, msg, ...)                                                     \
-    fprintf(                                                                                 \
-        stderr, "%s" CLI_INFO_SYM "%s%s " title "%s: " msg "\n", CLI_FORE_BRBLUE, CLI_RESET, \
-        CLI_BOLD, CLI_RESET, __VA_ARGS__                                                     \
-    )
+#if CLI_OUTPUT_BUFFER_SIZE < CLI_OUTPUT_LINE_SIZE
+#error "CLI_OUTPUT_BUFFER_SIZE cannot be less than CLI_OUTPUT_LINE_SIZE."
 #endif
-
-#ifndef cli_printf_debug
-#define cli_printf_debug(msg, ...)                                                                 \
-    fprintf(                                                                                       \
-        stderr, "%s" __FILE__ ":" CLI_STR(__LINE__) ":%s%sDebug%s: " msg "\n", CLI_DIM, CLI_RESET, \
-        CLI_BOLD, CLI_RESET, __VA_ARGS__                                                           \
-    )
+#if (CLI_OUTPUT_RING_SIZE & (CLI_OUTPUT_RING_SIZE - 1)) != 0
+#error "CLI_OUTPUT_RING_SIZE must be a power of two."
 #endif
+#endif // CLI_OUTPUT_THREADS
 
-    void
-    cli_toggle_styles(void) {
-#ifndef CLI_NO_STYLES
-    if (CLI_RESET[0]) {
-        CLI_RESET = "";
-        CLI_BOLD = "";
-        CLI_DIM = "";
-        CLI_FORE_RED = "";
-        CLI_FORE_BRBLUE = "";
-    } else {
-        CLI_RESET = "\033[0m";
-        CLI_BOLD = "\033[1m";
-        CLI_DIM = "\033[2m";
-        CLI_FORE_RED = "\033[31m";
-        CLI_FORE_BRBLUE = "\033[94m";
+#ifdef CLI_OUTPUT_BUFFER_SIZE
+#include <stdarg.h>
+
+static char cli_output_buffer[CLI_OUTPUT_BUFFER_SIZE];
+static size_t cli_output_length = 0;
+static bool cli_output_at_exit = false;
+
+// Write the buffer, which stays owned by the caller of cli_flush().
+static void cli_output_write(void) {
+    if (cli_output_length) {
+        // stderr is unbuffered, so the whole buffer takes a single write.
+        fwrite(cli_output_buffer, 1, cli_output_length, stderr);
+        cli_output_length = 0;
     }
-#endif // CLI_NO_STYLES
 }
 
-#ifdef CLI_NOHEAP_IMPLEMENTATION
-#define cli_da_init(array, _, __)                                                          \
-    {                                                                                      \
-        CLI_ASSERT(                                                                        \
-            (array).stack                                                                  \
-            && "(" #array                                                                  \
-               ").stack is not initalized. Use cli_parse_noheap() instead of cli_parse()." \
-        );                                                                                 \
-        (array).data = CLI_INVALID_PTR;                                                    \
-    }
-#define cli_da_append(array, item)                  \
-    {                                               \
-        const char** node = *((array).next_unused); \
-        if ((array).data == CLI_INVALID_PTR) {      \
-            (array).data = node;                    \
-        }                                           \
-        *node = (item);                             \
-        *(array).next_unused += 1;                  \
-        (array).length++;                           \
+static void cli_output_register(void) {
+    if (!__atomic_exchange_n(&cli_output_at_exit, true, __ATOMIC_RELAXED)) {
+        atexit(cli_flush);
     }
+}
+#endif // CLI_OUTPUT_BUFFER_SIZE
 
-enum CliError cli_parse_noheap(int argc, char** argv, struct Cli* cli, const char** stack) {
-    const char** unused = stack;
+#ifdef CLI_OUTPUT_THREADS
+// A bounded queue of lines with many producers and a single consumer.
+//
+// Position `n` of the queue is stored in the slot `n % CLI_OUTPUT_RING_SIZE`
+// in the turn `n / CLI_OUTPUT_RING_SIZE`. For the turn `t`, the sequence of
+// the slot is `2 * t` when the slot is free and `2 * t + 1` when it holds
+// a line, so zero-initialized slots are free for the first turn.
+struct CliOutputSlot {
+    size_t sequence;
+    size_t length;
+    char line[CLI_OUTPUT_LINE_SIZE];
+};
 
-    cli->args = (struct CliArray) { .stack = stack, .next_unused = &unused };
-    cli->cmd_options = (struct CliArray) { .stack = stack, .next_unused = &unused };
-    cli->program_options = (struct CliArray) { .stack = stack, .next_unused = &unused };
+static struct CliOutputSlot cli_output_ring[CLI_OUTPUT_RING_SIZE];
+// The next position to take a line from. Changed only while flushing.
+static size_t cli_output_head = 0;
+// The next position to put a line to.
+static size_t cli_output_tail = 0;
+static bool cli_output_flushing = false;
+static __thread char cli_output_line[CLI_OUTPUT_LINE_SIZE];
 
-    return cli_parse(argc, argv, cli);
+static bool cli_output_ready(size_t position) {
+    const struct CliOutputSlot* slot = &cli_output_ring[position % CLI_OUTPUT_RING_SIZE];
+    size_t turn = position / CLI_OUTPUT_RING_SIZE * 2;
+    return __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) == turn + 1;
+}
+
+void cli_flush(void) {
+    do {
+        if (__atomic_exchange_n(&cli_output_flushing, true, __ATOMIC_ACQUIRE)) {
+            return; // The lines are taken by another thread.
+        }
+        size_t head = cli_output_head;
+        while (cli_output_ready(head)) {
+            struct CliOutputSlot* slot = &cli_output_ring[head % CLI_OUTPUT_RING_SIZE];
+            if (cli_output_length + slot->length > CLI_OUTPUT_BUFFER_SIZE) {
+                cli_output_write();
+            }
+            memcpy(cli_output_buffer + cli_output_length, slot->line, slot->length);
+            cli_output_length += slot->length;
+            __atomic_store_n(
+                &slot->sequence, (head / CLI_OUTPUT_RING_SIZE + 1) * 2, __ATOMIC_RELEASE
+            );
+            head++;
+        }
+        __atomic_store_n(&cli_output_head, head, __ATOMIC_RELAXED);
+        cli_output_write();
+        __atomic_store_n(&cli_output_flushing, false, __ATOMIC_RELEASE);
+        // Lines that were published while the flag was set would wait for
+        // the next flush otherwise.
+    } while (cli_output_ready(__atomic_load_n(&cli_output_head, __ATOMIC_RELAXED)));
+}
+
+// Publish a formatted line and flush the ring if `flush` is true.
+//
+// Lines are never dropped: if the ring is full, the thread flushes it. If
+// another thread is flushing it, this one yields until a slot is freed.
+static inline void cli_output(bool flush, const char* format, ...) {
+    cli_output_register();
+
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(cli_output_line, CLI_OUTPUT_LINE_SIZE, format, args);
+    va_end(args);
+    if (length < 0) {
+        return;
+    }
+    if (length >= CLI_OUTPUT_LINE_SIZE) {
+        length = CLI_OUTPUT_LINE_SIZE - 1;
+        cli_output_line[length - 1] = '\n';
+    }
+
+    struct CliOutputSlot* slot;
+    size_t turn;
+    size_t position = __atomic_load_n(&cli_output_tail, __ATOMIC_RELAXED);
+    for (;;) {
+        slot = &cli_output_ring[position % CLI_OUTPUT_RING_SIZE];
+        turn = position / CLI_OUTPUT_RING_SIZE * 2;
+        size_t sequence = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+        if (sequence == turn) {
+            if (__atomic_compare_exchange_n(
+                    &cli_output_tail, &position, position + 1, true, __ATOMIC_RELAXED,
+                    __ATOMIC_RELAXED
+                )) {
+                break;
+            }
+        } else if (sequence < turn) {
+            // The line of the previous turn is not taken yet.
+            if (__atomic_load_n(&cli_output_flushing, __ATOMIC_RELAXED)) {
+                CLI_OUTPUT_YIELD();
+            } else {
+                cli_flush();
+            }
+            position = __atomic_load_n(&cli_output_tail, __ATOMIC_RELAXED);
+        } else {
+            position = __atomic_load_n(&cli_output_tail, __ATOMIC_RELAXED);
+        }
+    }
+    memcpy(slot->line, cli_output_line, length);
+    slot->length = length;
+    __atomic_store_n(&slot->sequence, turn + 1, __ATOMIC_RELEASE);
+
+    if (flush) {
+        cli_flush();
+    }
+}
+#elif defined(CLI_OUTPUT_BUFFER_SIZE)
+void cli_flush(void) {
+    cli_output_write();
+}
+
+// Append a formatted message to the buffer and flush it if `flush` is true.
+//
+// Messages that do not fit into the empty buffer are printed directly.
+static inline void cli_output(bool flush, const char* format, ...) {
+    cli_output_register();
+
+    va_list args;
+    for (int attempt = 0; attempt < 2; attempt++) {
+        size_t left = CLI_OUTPUT_BUFFER_SIZE - cli_output_length;
+        va_start(args, format);
+        int length = vsnprintf(cli_output_buffer + cli_output_length, left, format, args);
+        va_end(args);
+        if (length < 0) {
+            return;
+        }
+        if ((size_t)length < left) {
+            cli_output_length += length;
+            if (flush) {
+                cli_flush();
+            }
+            return;
+        }
+        if (cli_output_length == 0) {
+            break;
+        }
+        cli_flush();
+    }
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+}
+#endif // CLI_OUTPUT_THREADS
+
+#ifdef CLI_OUTPUT_BUFFER_SIZE
+#define cli_output_error(...) cli_output(true, __VA_ARGS__)
+#define cli_output_info(...)  cli_output(false, __VA_ARGS__)
+#else
+void cli_flush(void) {}
+
+#define cli_output_error(...) fprintf(stderr, __VA_ARGS__)
+#define cli_output_info(...)  fprintf(stderr, __VA_ARGS__)
+#endif // CLI_OUTPUT_BUFFER_SIZE
+
+int cli_log_level = CLI_LOG_LEVEL;
+
+#define cli_output_if(level, output) ((cli_log_level <= (level)) ? (void)(output) : (void)0)
+
+#if CLI_LOG_LEVEL <= CLI_LOG_ERROR
+#define cli_log_error(...) cli_output_if(CLI_LOG_ERROR, cli_output_error(__VA_ARGS__))
+#else
+#define cli_log_error(...) ((void)0)
+#endif
+
+#if CLI_LOG_LEVEL <= CLI_LOG_INFO
+#define cli_log_info(...) cli_output_if(CLI_LOG_INFO, cli_output_info(__VA_ARGS__))
+#else
+#define cli_log_info(...) ((void)0)
+#endif
+
+#if CLI_LOG_LEVEL <= CLI_LOG_DEBUG
+#define cli_log_debug(...) cli_output_if(CLI_LOG_DEBUG, cli_output_info(__VA_ARGS__))
+#else
+#define cli_log_debug(...) ((void)0)
+#endif
+
+#ifndef cli_print_error
+#define cli_print_error(title, msg)                                                          \
+    cli_log_error(                                                                           \
+        "%s" CLI_ERROR_SYM "%s%s " title "%s: " msg "\n", CLI_FORE_RED, CLI_RESET, CLI_BOLD, \
+        CLI_RESET                                                                            \
+    )
+#endif
+
+#ifndef cli_printf_error
+#define cli_printf_error(title, msg, ...)                                                    \
+    cli_log_error(                                                                           \
+        "%s" CLI_ERROR_SYM "%s%s " title "%s: " msg "\n", CLI_FORE_RED, CLI_RESET, CLI_BOLD, \
+        CLI_RESET, __VA_ARGS__                                                               \
+    )
+#endif
+
+#ifndef cli_print_info
+#define cli_print_info(title, msg)                                                             \
+    cli_log_info(                                                                              \
+        "%s" CLI_INFO_SYM "%s%s " title "%s: " msg "\n", CLI_FORE_BRBLUE, CLI_RESET, CLI_BOLD, \
+        CLI_RESET                                                                              \
+    )
+#endif
+
+#ifndef cli_printf_info
+#define cli_printf_info(title, msg, ...)                                                       \
+    cli_log_info(                                                                              \
+        "%s" CLI_INFO_SYM "%s%s " title "%s: " msg "\n", CLI_FORE_BRBLUE, CLI_RESET, CLI_BOLD, \
+        CLI_RESET, __VA_ARGS__                                                                 \
+    )
+#endif
+
+#ifndef cli_printf_debug
+#define cli_printf_debug(msg, ...)                                                       \
+    cli_log_debug(                                                                       \
+        "%s" __FILE__ ":" CLI_STR(__LINE__) ":%s%sDebug%s: " msg "\n", CLI_DIM, CLI_RESET, \
+        CLI_BOLD, CLI_RESET, __VA_ARGS__                                                 \
+    )
+#endif
+
+struct CliStyle cli_stderr_style = { "", "", "", "", "", 0 };
+struct CliStyle cli_stdout_style = { "", "", "", "", "", 0 };
+
+void cli_set_styles(struct CliStyle* style, int enabled) {
+#ifndef CLI_NO_STYLES
+    if (enabled) {
+        style->reset = "\033[0m";
+        style->bold = "\033[1m";
+        style->dim = "\033[2m";
+        style->fore_red = "\033[31m";
+        style->fore_brblue = "\033[94m";
+    } else {
+        style->reset = "";
+        style->bold = "";
+        style->dim = "";
+        style->fore_red = "";
+        style->fore_brblue = "";
+    }
+#else
+    (void)style;
+    (void)enabled;
+#endif // CLI_NO_STYLES
+}
+
+void cli_toggle_styles(void) {
+    int enabled = !CLI_RESET[0];
+    cli_set_styles(&cli_stderr_style, enabled);
+    cli_set_styles(&cli_stdout_style, enabled);
+}
+
+void cli_detect_styles(void) {
+#ifndef CLI_NO_STYLES
+    const char* no_color = getenv("NO_COLOR");
+    const char* term = getenv("TERM");
+    bool allowed = !(no_color && no_color[0]) && !(term && strcmp(term, "dumb") == 0);
+#ifdef CLI_ISATTY
+    cli_stderr_style.terminal = isatty(STDERR_FILENO);
+    cli_stdout_style.terminal = isatty(STDOUT_FILENO);
+#endif
+    cli_set_styles(&cli_stderr_style, allowed && cli_stderr_style.terminal);
+    cli_set_styles(&cli_stdout_style, allowed && cli_stdout_style.terminal);
+#endif // CLI_NO_STYLES
+}
+
+#ifdef CLI_PROGRESS
+static unsigned long long cli_progress_now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (unsigned long long)time.tv_sec * 1000000000 + time.tv_nsec;
+}
+
+// Status lines are written right away, like error messages.
+//
+// The status line is ended if `last` is true.
+static void cli_progress_draw(
+    const struct CliProgress* progress, unsigned long long count, bool last
+) {
+    if (CLI_LOG_LEVEL > CLI_LOG_INFO || cli_log_level > CLI_LOG_INFO) {
+        return;
+    }
+    const char* start = progress->in_place ? "\r" : "";
+    const char* end = !progress->in_place ? "\n" : last ? "\033[K\n" : "\033[K";
+    if (progress->total) {
+        cli_output_error(
+            "%s%s" CLI_INFO_SYM "%s%s %s%s: %llu/%llu (%u%%)%s", start, CLI_FORE_BRBLUE, CLI_RESET,
+            CLI_BOLD, progress->title, CLI_RESET, count, progress->total,
+            (unsigned)(count * 100.0 / progress->total), end
+        );
+    } else {
+        cli_output_error(
+            "%s%s" CLI_INFO_SYM "%s%s %s%s: %llu%s", start, CLI_FORE_BRBLUE, CLI_RESET, CLI_BOLD,
+            progress->title, CLI_RESET, count, end
+        );
+    }
+}
+
+// The number of items before the first check of the time.
+#define CLI_PROGRESS_STEP 16
+
+void cli_progress_begin(
+    struct CliProgress* progress, const char* title, unsigned long long total, unsigned rate
+) {
+    CLI_ASSERT(rate && "The rate of redraws cannot be 0.");
+    *progress = CLI_ZERO_LITERAL(struct CliProgress);
+    progress->title = title;
+    progress->total = total;
+    progress->check_at = CLI_PROGRESS_STEP;
+    progress->step = CLI_PROGRESS_STEP;
+    progress->drawn_at = cli_progress_now();
+    progress->interval = 1000000000 / rate;
+    progress->in_place = CLI_RESET[0] && cli_stderr_style.terminal;
+}
+
+void cli_progress_check(struct CliProgress* progress) {
+    // Other threads do not wait for the redraw.
+    if (__atomic_exchange_n(&progress->drawing, 1, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    unsigned long long count = __atomic_load_n(&progress->count, __ATOMIC_RELAXED);
+    unsigned long long now = cli_progress_now();
+    if (now - progress->drawn_at >= progress->interval) {
+        cli_progress_draw(progress, count, false);
+        // Check the time about 16 times per redraw, if the speed is the same.
+        progress->step = (count - progress->drawn_count) / 16 + 1;
+        progress->drawn_count = count;
+        progress->drawn_at = now;
+    } else if (progress->drawn_count == 0) {
+        // Until the first redraw, the speed is unknown, so the step grows
+        // until the time is checked about once per interval.
+        progress->step *= 2;
+    }
+    __atomic_store_n(&progress->check_at, count + progress->step, __ATOMIC_RELAXED);
+    __atomic_store_n(&progress->drawing, 0, __ATOMIC_RELEASE);
+}
+
+void cli_progress_end(struct CliProgress* progress) {
+    cli_progress_draw(progress, __atomic_load_n(&progress->count, __ATOMIC_RELAXED), true);
+}
+#endif // CLI_PROGRESS
+
+#if defined(CLI_TIMERS) && CLI_LOG_LEVEL <= CLI_LOG_DEBUG
+// A site of CLI_TIME_END() with statistics of its scopes in ticks.
+struct CliTimer {
+    const char* name;
+    const char* file;
+    int line;
+    unsigned long long count;
+    unsigned long long total;
+    unsigned long long min;
+    unsigned long long max;
+    // The next measured site.
+    struct CliTimer* next;
+};
+
+// Sites in the order of their first measurement.
+static struct CliTimer* cli_timers = NULL;
+static struct CliTimer** cli_timers_end = &cli_timers;
+static unsigned long long cli_timers_started_at[2];
+
+static inline unsigned long long cli_time_ns(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (unsigned long long)time.tv_sec * 1000000000 + time.tv_nsec;
+}
+
+// The time in ticks, which are nanoseconds unless the TSC is used.
+static inline unsigned long long cli_time_now(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    return cli_time_ns();
+#endif
+}
+
+// Save the time both in ticks and in nanoseconds, so ticks can be converted.
+__attribute__((constructor)) static void cli_time_start(void) {
+    cli_timers_started_at[0] = cli_time_now();
+    cli_timers_started_at[1] = cli_time_ns();
+}
+
+static inline void cli_time_add(struct CliTimer* timer, unsigned long long ticks) {
+    if (timer->count++ == 0) {
+        if (cli_timers == NULL) {
+            atexit(cli_time_report);
+        }
+        timer->min = ticks;
+        *cli_timers_end = timer;
+        cli_timers_end = &timer->next;
+    }
+    timer->total += ticks;
+    timer->min = ticks < timer->min ? ticks : timer->min;
+    timer->max = ticks > timer->max ? ticks : timer->max;
+}
+
+void cli_time_report(void) {
+    double ns_per_tick = 1.0;
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned long long ticks = cli_time_now() - cli_timers_started_at[0];
+    unsigned long long ns = cli_time_ns() - cli_timers_started_at[1];
+    if (ticks) {
+        ns_per_tick = (double)ns / ticks;
+    }
+#endif
+    for (const struct CliTimer* timer = cli_timers; timer; timer = timer->next) {
+        cli_log_debug(
+            "%s%s:%d:%s%sTiming%s: %s: %llu calls, %.3f ms total, %.3f/%.3f/%.3f us "
+            "min/avg/max\n",
+            CLI_DIM, timer->file, timer->line, CLI_RESET, CLI_BOLD, CLI_RESET, timer->name,
+            timer->count, timer->total * ns_per_tick / 1e6, timer->min * ns_per_tick / 1e3,
+            (double)timer->total / timer->count * ns_per_tick / 1e3,
+            timer->max * ns_per_tick / 1e3
+        );
+    }
+    // At exit, the buffer may be flushed already.
+    cli_flush();
+}
+
+// Start measuring a scope called `name` (an identifier) until CLI_TIME_END().
+#define CLI_TIME_BEGIN(name) unsigned long long cli_time_##name = cli_time_now()
+
+// Stop measuring the scope started by CLI_TIME_BEGIN() with the same name.
+#define CLI_TIME_END(name)                                                                \
+    do {                                                                                  \
+        static struct CliTimer cli_timer = { #name, __FILE__, __LINE__, 0, 0, 0, 0, NULL }; \
+        cli_time_add(&cli_timer, cli_time_now() - cli_time_##name);                       \
+    } while (0)
+#elif defined(CLI_TIMERS)
+void cli_time_report(void) {}
+
+#define CLI_TIME_BEGIN(name) ((void)0)
+#define CLI_TIME_END(name)   ((void)0)
+#endif // CLI_TIMERS && CLI_LOG_LEVEL <= CLI_LOG_DEBUG
+
+#ifdef CLI_NOHEAP_IMPLEMENTATION
+#define cli_da_init(array, _, __, ___)                                                     \
+    {                                                                                      \
+        CLI_ASSERT(                                                                        \
+            (array).stack                                                                  \
+            && "(" #array                                                                  \
+               ").stack is not initalized. Use cli_parse_noheap() instead of cli_parse()." \
+        );                                                                                 \
+        (array).length = 0;                                                                \
+        (array).data = (array).stack;                                                      \
+    }
+// Arrays are always filled in the same order: program options, then arguments,
+// then command options (see cli_parse()). Thus, when an array receives its
+// first item, every item stored in the stack so far belongs to the previous
+// arrays, and the new array starts right after them.
+#define cli_da_append(array, item)                                                     \
+    {                                                                                  \
+        if ((array).length == 0) {                                                     \
+            (array).data = (array).stack + cli->program_options.length + cli->args.length \
+                + cli->cmd_options.length;                                             \
+        }                                                                              \
+        (array).data[(array).length++] = (item);                                       \
+    }
+
+enum CliError cli_parse_noheap(int argc, char** argv, struct Cli* cli, const char** stack) {
+    *cli = CLI_ZERO_LITERAL(struct Cli);
+    cli->args.stack = stack;
+    cli->cmd_options.stack = stack;
+    cli->program_options.stack = stack;
+
+    return cli_parse(argc, argv, cli);
 }
 #endif // CLI_NOHEAP_IMPLEMENTATION
 
-#ifndef cli_da_init
-#define cli_da_init(array, item_t, da_malloc)                                      \
-    {                                                                              \
-        (array).capacity = CLI_DEFAULT_ARR_CAP;                                    \
-        (array).length = 0;                                                        \
-        (array).data = (item_t*)(da_malloc)(CLI_DEFAULT_ARR_CAP * sizeof(item_t)); \
+#ifdef CLI_ARENA
+// Arrays share the arena in the same way as the stack of
+// CLI_NOHEAP_IMPLEMENTATION.
+#define cli_da_init(array, item_t, _, __)   \
+    {                                       \
+        (array).capacity = 0;               \
+        (array).length = 0;                 \
+        (array).data = (item_t*)cli->arena; \
+    }
+#define cli_da_append(array, item)                                                     \
+    {                                                                                  \
+        if ((array).length == 0) {                                                     \
+            (array).data = cli->arena + cli->program_options.length + cli->args.length \
+                + cli->cmd_options.length;                                             \
+        }                                                                              \
+        (array).data[(array).length++] = (item);                                       \
+        (array).capacity = (array).length;                                             \
+    }
+#endif // CLI_ARENA
+
+#ifndef cli_da_init
+// Arrays that already have enough room (see cli_parse_into()) are reused.
+#define cli_da_init(array, item_t, da_malloc, cap)                          \
+    {                                                                       \
+        (array).length = 0;                                                 \
+        if ((array).capacity < (cap)) {                                     \
+            CLI_FREE((array).data);                                         \
+            (array).data = (item_t*)(da_malloc)((cap) * sizeof(item_t));    \
+            (array).capacity = (array).data ? (cap) : 0;                    \
+            cli_stats_add(cli, NULL, (array).data, (cap) * sizeof(item_t)); \
+        }                                                                   \
+    }
+#endif
+
+#ifndef cli_da_append
+#define cli_da_append(array, item)                                                         \
+    {                                                                                      \
+        if (++(array).length > (array).capacity) {                                         \
+            if ((array).capacity > CLI_SIZE_MAX / 2                                        \
+                || (size_t)(array).capacity > (size_t)-1 / 2 / sizeof(item)) {             \
+                cli_print_error("Memory error", "Too many array items.");                  \
+                CLI_ASSERT(0 && "Memory error");                                           \
+                return CliErrorFatal;                                                      \
+            }                                                                              \
+            (array).capacity = (array).capacity ? (array).capacity * 2 : 1;                \
+            const void* cli_da_old = (array).data;                                         \
+            (array).data = (__typeof__(item)*)CLI_REALLOC(                                 \
+                (array).data, (array).capacity * sizeof(item)                              \
+            );                                                                             \
+            cli_stats_add(cli, cli_da_old, (array).data, (array).capacity * sizeof(item)); \
+            if ((array).data == NULL) {                                                    \
+                cli_print_error(                                                           \
+                    "Memory error", "Unable to reallocate memory for more array items."    \
+                );                                                                         \
+                CLI_ASSERT(0 && "Memory error");                                           \
+                return CliErrorFatal;                                                      \
+            }                                                                              \
+        }                                                                                  \
+        (array).data[(array).length - 1] = (item);                                         \
+    }
+#endif
+
+static const char* cli_pop_argv(int* argc, char*** argv) {
+    CLI_ASSERT(*argc);
+    (*argc)--;
+    return *((*argv)++);
+}
+
+// A state that is required to classify the next token.
+struct CliClassifier {
+    bool is_cmd_option;
+    bool has_cmd_options;
+    // The last positional argument or NULL.
+    const char* last_arg;
+};
+
+// Classify `arg` according to the tokens that precede it.
+//
+// All passes over the command line must use this function, so the rules stay
+// the same regardless of how the results are stored.
+static enum CliError cli_classify(
+    struct CliClassifier* state, const char* arg, enum CliToken* token
+) {
+    if (arg[0] == '-') {
+        if (arg[1] == '-' && arg[2] == '\0') {
+            if (state->last_arg) {
+                cli_printf_error(
+                    "CLI error",
+                    "Double dash ('%s') cannot be specified after the positional argument ('%s').",
+                    arg, state->last_arg
+                );
+                return CliErrorUser;
+            }
+            state->is_cmd_option = true;
+            *token = CliTokenDoubleDash;
+        } else if (state->is_cmd_option) {
+            state->has_cmd_options = true;
+            *token = CliTokenCmdOption;
+        } else {
+            *token = CliTokenProgramOption;
+        }
+    } else {
+        if (state->has_cmd_options) {
+            cli_printf_error(
+                "CLI error",
+                "Positional arguments ('%s') should be specified prior to command options.", arg
+            );
+            return CliErrorUser;
+        }
+        state->is_cmd_option = true;
+        state->last_arg = arg;
+        *token = CliTokenArgument;
+    }
+    return CliErrorOk;
+}
+
+static struct CliArray* cli_bucket(Cli* cli, enum CliToken token) {
+    switch (token) {
+    case CliTokenArgument:
+        return &cli->args;
+    case CliTokenCmdOption:
+        return &cli->cmd_options;
+    case CliTokenProgramOption:
+        return &cli->program_options;
+    default:
+        return NULL;
+    }
+}
+
+#ifdef CLI_OPTION_VIEWS
+static struct CliOption cli_split_option(const char* option) {
+    struct CliOption view;
+    const char* c = option;
+    while (*c == '-') c++;
+    view.dashes = c - option;
+    view.key = c;
+    while (*c && *c != '=') c++;
+    view.key_length = c - view.key;
+    view.value = *c ? c + 1 : NULL;
+    return view;
+}
+#endif // CLI_OPTION_VIEWS
+
+#ifdef CLI_INDEX
+// Keys of folded tables (e.g. of environment variables) are compared ignoring
+// case and treating `-` as `_`.
+static inline unsigned char cli_fold(char c) {
+    if (c >= 'a' && c <= 'z') {
+        return c - 'a' + 'A';
+    }
+    return c == '-' ? '_' : c;
+}
+
+// FNV-1a.
+static unsigned long cli_hash(const char* key, CLI_SIZE_T length, bool fold) {
+    unsigned long hash = 2166136261u;
+    for (CLI_SIZE_T i = 0; i < length; i++) {
+        hash = (hash ^ (fold ? cli_fold(key[i]) : (unsigned char)key[i])) * 16777619u;
+    }
+    return hash;
+}
+
+static bool cli_keys_equal(const char* a, const char* b, CLI_SIZE_T length, bool fold) {
+    if (!fold) {
+        return memcmp(a, b, length) == 0;
+    }
+    for (CLI_SIZE_T i = 0; i < length; i++) {
+        if (cli_fold(a[i]) != cli_fold(b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Find a slot with `key` or an empty slot, where it should be placed.
+static const struct CliOption**
+cli_index_find(const struct CliIndex* index, const char* key, CLI_SIZE_T length, bool fold) {
+    CLI_SIZE_T i = cli_hash(key, length, fold) % index->capacity;
+    const struct CliOption* slot;
+    while ((slot = index->slots[i])) {
+        if (slot->key_length == length && cli_keys_equal(slot->key, key, length, fold)) {
+            break;
+        }
+        if (++i == index->capacity) i = 0;
+    }
+    return &index->slots[i];
+}
+
+// Fill `index` with `length` options, using `slots` as its storage.
+//
+// `slots` should have room for `2 * length` items, so the table is at most
+// half full. Later options replace earlier ones with the same key.
+static void cli_index_build(
+    struct CliIndex* index, const struct CliOption* options, CLI_SIZE_T length,
+    const struct CliOption** slots, bool fold
+) {
+    index->capacity = length * 2;
+    index->slots = slots;
+    for (CLI_SIZE_T i = 0; i < index->capacity; i++) index->slots[i] = NULL;
+    for (CLI_SIZE_T i = 0; i < length; i++) {
+        *cli_index_find(index, options[i].key, options[i].key_length, fold) = &options[i];
+    }
+}
+
+static const struct CliOption*
+cli_index_lookup(const struct CliIndex* index, const char* key, bool fold) {
+    if (index->capacity == 0) {
+        return NULL;
+    }
+    struct CliOption lookup = cli_split_option(key);
+    return *cli_index_find(index, lookup.key, lookup.key_length, fold);
+}
+
+#ifdef CLI_OPTIONS
+// Check whether the key of `option` is the full `name` or the `alias` of an
+// option of CLI_OPTIONS.
+static bool
+cli_option_is(const struct CliOption* option, const char* name, size_t length, char alias) {
+    if (option->key_length == 1 && alias && option->key[0] == alias) {
+        return true;
+    }
+    return option->key_length == length && memcmp(option->key, name, length) == 0;
+}
+#endif
+
+// Find the program option `key`, falling back to layers of lower precedence.
+//
+// Options of CLI_OPTIONS are resolved by their names and aliases, as their
+// layers are merged by cli_parse() already.
+static const struct CliOption* cli_find_option(const Cli* cli, const char* key) {
+#ifdef CLI_OPTIONS
+    struct CliOption lookup = cli_split_option(key);
+#define CLI_X_SOURCE(name, alias, kind, default_value)               \
+    if (cli_option_is(&lookup, #name, sizeof(#name) - 1, (alias))) { \
+        return cli->option_sources[CliOptionId_##name];              \
+    }
+    CLI_OPTIONS(CLI_X_SOURCE)
+#undef CLI_X_SOURCE
+#endif
+    const struct CliOption* option = cli_index_lookup(&cli->program_index, key, false);
+#ifdef CLI_ENV_PREFIX
+    if (option == NULL) {
+        option = cli_index_lookup(&cli->env_index, key, true);
+    }
+#endif
+#ifdef CLI_CONFIG_FILES
+    for (CLI_SIZE_T i = cli->config_files_length; option == NULL && i > 0; i--) {
+        option = cli_index_lookup(&cli->config_files[i - 1].index, key, false);
+    }
+#endif
+    return option;
+}
+
+static const char* cli_option_value(const struct CliOption* option) {
+    if (option == NULL) {
+        return NULL;
+    }
+    return option->value ? option->value : option->key + option->key_length;
+}
+
+const char* cli_get_option(const Cli* cli, const char* key) {
+    return cli_option_value(cli_find_option(cli, key));
+}
+
+const char* cli_get_cmd_option(const Cli* cli, const char* key) {
+    return cli_option_value(cli_index_lookup(&cli->cmd_index, key, false));
+}
+#endif // CLI_INDEX
+
+#if defined(CLI_ENV_PREFIX) || defined(CLI_CONFIG_FILES)
+// The number of bytes that a view and its table take per variable or entry.
+#define CLI_ENV_VIEW_SIZE (sizeof(struct CliOption) + 2 * sizeof(const struct CliOption*))
+#endif
+
+#ifdef CLI_ENV_PREFIX
+
+// Take a snapshot of environment variables with CLI_ENV_PREFIX and index them
+// by names without the prefix. Names and values are not copied.
+static enum CliError cli_build_env(Cli* cli) {
+    const size_t prefix = sizeof(CLI_ENV_PREFIX) - 1;
+    CLI_SIZE_T length = 0;
+    for (char** var = environ; *var; var++) {
+        length += strncmp(*var, CLI_ENV_PREFIX, prefix) == 0;
+    }
+    if (length == 0) {
+        return CliErrorOk;
+    }
+    if (length > cli->env_capacity) {
+        size_t size = length * CLI_ENV_VIEW_SIZE;
+        CLI_FREE(cli->env_views);
+        cli->env_views = (struct CliOption*)CLI_MALLOC(size);
+        cli_stats_add(cli, NULL, cli->env_views, size);
+        if (cli->env_views == NULL) {
+            cli->env_capacity = 0;
+            cli_print_error(
+                "Memory error", "Unable to allocate memory for environment variables."
+            );
+            return CliErrorFatal;
+        }
+        cli->env_capacity = length;
+    }
+
+    CLI_SIZE_T count = 0;
+    for (char** var = environ; *var && count < length; var++) {
+        if (strncmp(*var, CLI_ENV_PREFIX, prefix) == 0) {
+            struct CliOption* view = &cli->env_views[count++];
+            view->dashes = 0;
+            view->key = *var + prefix;
+            view->key_length = strcspn(view->key, "=");
+            view->value = view->key[view->key_length] ? view->key + view->key_length + 1 : NULL;
+        }
+    }
+    cli_index_build(
+        &cli->env_index, cli->env_views, count,
+        (const struct CliOption**)(cli->env_views + length), true
+    );
+    return CliErrorOk;
+}
+#endif // CLI_ENV_PREFIX
+
+#ifdef CLI_OPTION_VIEWS
+// The number of bytes that views and tables take per option.
+#ifdef CLI_INDEX
+#define CLI_OPTION_VIEW_SIZE                                        \
+    (sizeof(struct CliOption) + 2 * sizeof(const struct CliOption*) \
+     + CLI_OPTION_LIST_ITEMS * sizeof(const char*))
+#else
+#define CLI_OPTION_VIEW_SIZE \
+    (sizeof(struct CliOption) + CLI_OPTION_LIST_ITEMS * sizeof(const char*))
+#endif
+
+// Split all options of `cli` and build tables of them if `CLI_INDEX` is
+// defined.
+//
+// Views and tables are stored in a single block (or in the stack for
+// `CLI_NOHEAP`): program option views, command option views, values of LIST
+// options (see cli_options_parse()), then tables.
+static enum CliError cli_build_views(Cli* cli) {
+    // Indexes are already emptied by cli_reset().
+    CLI_SIZE_T options = cli->program_options.length + cli->cmd_options.length;
+    if (options == 0) {
+        cli->cmd_option_views = cli->program_option_views;
+        return CliErrorOk;
+    }
+
+#ifdef CLI_NOHEAP
+    // Views and tables are stored in the stack after all arrays.
+    const char** end = cli->args.stack + cli->program_options.length + cli->args.length
+        + cli->cmd_options.length;
+    struct CliOption* views = (struct CliOption*)end;
+    cli->program_option_views = views;
+#else
+    if (options > cli->option_views_capacity) {
+        size_t size = options * CLI_OPTION_VIEW_SIZE;
+        CLI_FREE(cli->program_option_views);
+        cli->program_option_views = (struct CliOption*)CLI_MALLOC(size);
+        cli_stats_add(cli, NULL, cli->program_option_views, size);
+        if (cli->program_option_views == NULL) {
+            cli->option_views_capacity = 0;
+            cli_print_error("Memory error", "Unable to allocate memory for option views.");
+            return CliErrorFatal;
+        }
+        cli->option_views_capacity = options;
+    }
+    struct CliOption* views = cli->program_option_views;
+#endif // CLI_NOHEAP
+
+    for (CLI_SIZE_T i = 0; i < cli->program_options.length; i++) {
+        *views++ = cli_split_option(cli->program_options.data[i]);
+    }
+    cli->cmd_option_views = views;
+    for (CLI_SIZE_T i = 0; i < cli->cmd_options.length; i++) {
+        *views++ = cli_split_option(cli->cmd_options.data[i]);
+    }
+#ifdef CLI_OPTIONS
+    views = (struct CliOption*)((const char**)views
+                                + CLI_OPTION_LIST_ITEMS * cli->program_options.length);
+#endif
+
+#ifdef CLI_INDEX
+    const struct CliOption** slots = (const struct CliOption**)views;
+    cli_index_build(
+        &cli->program_index, cli->program_option_views, cli->program_options.length, slots,
+        false
+    );
+    cli_index_build(
+        &cli->cmd_index, cli->cmd_option_views, cli->cmd_options.length,
+        slots + cli->program_index.capacity, false
+    );
+#endif
+    return CliErrorOk;
+}
+#endif // CLI_OPTION_VIEWS
+
+#if defined(CLI_INDEX) || defined(CLI_OPTIONS)
+// Converters of option values. They do not rely on the locale and fail on any
+// trailing characters.
+
+// Convert leading decimal digits of `*str` and move it past them.
+static bool cli_str_to_digits(const char** str, unsigned long long* result) {
+    const char* c = *str;
+    unsigned long long value = 0;
+    for (; *c >= '0' && *c <= '9'; c++) {
+        unsigned digit = *c - '0';
+        if (value > ((unsigned long long)-1 - digit) / 10) {
+            return false;
+        }
+        value = value * 10 + digit;
+    }
+    if (c == *str) {
+        return false;
+    }
+    *str = c;
+    *result = value;
+    return true;
+}
+
+static bool cli_str_to_u64(const char* str, unsigned long long* result) {
+    return cli_str_to_digits(&str, result) && *str == '\0';
+}
+
+static bool cli_str_to_i64(const char* str, long long* result) {
+    bool negative = *str == '-';
+    if (*str == '-' || *str == '+') str++;
+
+    unsigned long long value;
+    const unsigned long long max = 9223372036854775807ULL;
+    if (!cli_str_to_u64(str, &value) || value > max + negative) {
+        return false;
+    }
+    // -(max + 1) cannot be negated as a signed number.
+    *result = negative ? -(long long)(value - 1) - 1 : (long long)value;
+    return true;
+}
+
+// Digits beyond the precision of `unsigned long long` are dropped. The result
+// is exact when the mantissa has less than 16 digits and the exponent is
+// within [-22, 22], which covers practically every value on a command line.
+static bool cli_str_to_f64(const char* str, double* result) {
+    static const double powers[] = { 1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                                     1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                                     1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+    bool negative = *str == '-';
+    if (*str == '-' || *str == '+') str++;
+
+    unsigned long long mantissa = 0;
+    int digits = 0, exponent = 0;
+    bool any = false;
+    for (; *str >= '0' && *str <= '9'; str++, any = true) {
+        if (digits < 19) {
+            mantissa = mantissa * 10 + (*str - '0');
+            digits += mantissa != 0;
+        } else {
+            exponent++;
+        }
+    }
+    if (*str == '.') {
+        for (str++; *str >= '0' && *str <= '9'; str++, any = true) {
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (*str - '0');
+                digits += mantissa != 0;
+                exponent--;
+            }
+        }
+    }
+    if (!any) {
+        return false;
+    }
+    if (*str == 'e' || *str == 'E') {
+        str++;
+        bool negative_exponent = *str == '-';
+        if (*str == '-' || *str == '+') str++;
+        unsigned long long value;
+        if (!cli_str_to_u64(str, &value)) {
+            return false;
+        }
+        value = value > 100000 ? 100000 : value;
+        exponent += negative_exponent ? -(int)value : (int)value;
+    } else if (*str) {
+        return false;
+    }
+
+    double value = (double)mantissa;
+    for (; exponent > 22; exponent -= 22) value *= powers[22];
+    for (; exponent < -22; exponent += 22) value /= powers[22];
+    value = exponent < 0 ? value / powers[-exponent] : value * powers[exponent];
+    if (value - value != 0) {
+        // Infinity.
+        return false;
+    }
+    *result = negative ? -value : value;
+    return true;
+}
+
+// A number of bytes with an optional binary suffix: K, M, G or T, optionally
+// followed by B (e.g. `64K`, `1GB`, `512B`).
+static bool cli_str_to_size(const char* str, unsigned long long* result) {
+    unsigned long long value;
+    if (!cli_str_to_digits(&str, &value)) {
+        return false;
+    }
+    int shift = 0;
+    switch (*str | 0x20) {
+    case 'k': shift = 10; break;
+    case 'm': shift = 20; break;
+    case 'g': shift = 30; break;
+    case 't': shift = 40; break;
+    }
+    if (shift) str++;
+    if (*str == 'B' || *str == 'b') str++;
+    if (*str || value > (unsigned long long)-1 >> shift) {
+        return false;
+    }
+    *result = value << shift;
+    return true;
+}
+
+// A number of milliseconds with an optional unit: ms, s, m or h.
+static bool cli_str_to_duration(const char* str, unsigned long long* result) {
+    unsigned long long value, unit;
+    if (!cli_str_to_digits(&str, &value)) {
+        return false;
+    }
+    if (str[0] == '\0' || (str[0] == 'm' && str[1] == 's' && str[2] == '\0')) {
+        unit = 1;
+    } else if (str[1] != '\0') {
+        return false;
+    } else if (str[0] == 's') {
+        unit = 1000;
+    } else if (str[0] == 'm') {
+        unit = 60 * 1000;
+    } else if (str[0] == 'h') {
+        unit = 60 * 60 * 1000;
+    } else {
+        return false;
+    }
+    if (value > (unsigned long long)-1 / unit) {
+        return false;
+    }
+    *result = value * unit;
+    return true;
+}
+
+static enum CliError cli_require_value(const struct CliOption* option) {
+    if (option->value == NULL) {
+        cli_printf_error(
+            "CLI error", "Option '%.*s' requires a value.", (int)option->key_length, option->key
+        );
+        return CliErrorUser;
+    }
+    return CliErrorOk;
+}
+
+// Report an invalid value of `option` unless `is_valid`.
+static enum CliError
+cli_check_value(const struct CliOption* option, bool is_valid, const char* expected) {
+    if (!is_valid) {
+        cli_printf_error(
+            "CLI error", "Option '%.*s' requires %s, got '%s'.", (int)option->key_length,
+            option->key, expected, option->value
+        );
+        return CliErrorUser;
+    }
+    return CliErrorOk;
+}
+
+static inline enum CliError cli_set_string(const char** field, const struct CliOption* option) {
+    if (cli_require_value(option)) {
+        return CliErrorUser;
+    }
+    *field = option->value;
+    return CliErrorOk;
+}
+
+static inline enum CliError cli_set_int(long long* field, const struct CliOption* option) {
+    if (cli_require_value(option)) {
+        return CliErrorUser;
+    }
+    return cli_check_value(option, cli_str_to_i64(option->value, field), "an integer");
+}
+
+static inline enum CliError
+cli_set_uint(unsigned long long* field, const struct CliOption* option) {
+    if (cli_require_value(option)) {
+        return CliErrorUser;
+    }
+    return cli_check_value(option, cli_str_to_u64(option->value, field), "a non-negative integer");
+}
+
+static inline enum CliError cli_set_float(double* field, const struct CliOption* option) {
+    if (cli_require_value(option)) {
+        return CliErrorUser;
+    }
+    return cli_check_value(option, cli_str_to_f64(option->value, field), "a number");
+}
+
+static inline enum CliError
+cli_set_size(unsigned long long* field, const struct CliOption* option) {
+    if (cli_require_value(option)) {
+        return CliErrorUser;
+    }
+    return cli_check_value(
+        option, cli_str_to_size(option->value, field), "a size (e.g. 64K, 1G)"
+    );
+}
+
+static inline enum CliError
+cli_set_duration(unsigned long long* field, const struct CliOption* option) {
+    if (cli_require_value(option)) {
+        return CliErrorUser;
+    }
+    return cli_check_value(
+        option, cli_str_to_duration(option->value, field), "a duration (e.g. 250ms, 5s, 1m)"
+    );
+}
+#endif // CLI_INDEX || CLI_OPTIONS
+
+#ifdef CLI_INDEX
+// Typed accessors: an unspecified option leaves `result` untouched.
+
+enum CliError cli_get_i64(const Cli* cli, const char* key, long long* result) {
+    const struct CliOption* option = cli_find_option(cli, key);
+    return option ? cli_set_int(result, option) : CliErrorOk;
+}
+
+enum CliError cli_get_u64(const Cli* cli, const char* key, unsigned long long* result) {
+    const struct CliOption* option = cli_find_option(cli, key);
+    return option ? cli_set_uint(result, option) : CliErrorOk;
+}
+
+enum CliError cli_get_f64(const Cli* cli, const char* key, double* result) {
+    const struct CliOption* option = cli_find_option(cli, key);
+    return option ? cli_set_float(result, option) : CliErrorOk;
+}
+
+enum CliError cli_get_size(const Cli* cli, const char* key, unsigned long long* result) {
+    const struct CliOption* option = cli_find_option(cli, key);
+    return option ? cli_set_size(result, option) : CliErrorOk;
+}
+
+enum CliError cli_get_duration(const Cli* cli, const char* key, unsigned long long* result) {
+    const struct CliOption* option = cli_find_option(cli, key);
+    return option ? cli_set_duration(result, option) : CliErrorOk;
+}
+#endif // CLI_INDEX
+
+#if defined(CLI_COMMANDS) || defined(CLI_OPTIONS)
+// A name and its identifier in a table that is searched with cli_keys_bound().
+struct CliKey {
+    const char* name;
+    int id;
+};
+
+// Tables are small and sorted once, so an insertion sort is enough.
+static void cli_keys_sort(struct CliKey* keys, size_t length) {
+    for (size_t i = 1; i < length; i++) {
+        struct CliKey key = keys[i];
+        size_t j = i;
+        for (; j > 0 && strcmp(keys[j - 1].name, key.name) > 0; j--) {
+            keys[j] = keys[j - 1];
+        }
+        keys[j] = key;
+    }
+}
+
+// Sort `keys` on the first lookup. `state` is 0 until the table is sorted, 1
+// while it is being sorted and 2 afterwards, so if several threads parse at
+// the same time, the first one sorts it while the others wait. Without atomic
+// builtins, the first lookup has to happen before other threads start.
+static void cli_keys_sort_once(struct CliKey* keys, size_t length, int* state) {
+#if defined(__GNUC__) || defined(__clang__)
+    if (__atomic_load_n(state, __ATOMIC_ACQUIRE) == 2) {
+        return;
+    }
+    int unsorted = 0;
+    if (__atomic_compare_exchange_n(
+            state, &unsorted, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE
+        )) {
+        cli_keys_sort(keys, length);
+        __atomic_store_n(state, 2, __ATOMIC_RELEASE);
+    }
+    while (__atomic_load_n(state, __ATOMIC_ACQUIRE) != 2) {
+    }
+#else
+    if (*state != 2) {
+        cli_keys_sort(keys, length);
+        *state = 2;
+    }
+#endif
+}
+
+// Find the first key in the sorted range [begin, end) whose name (after the
+// first `offset` bytes, which are the same for the range) does not start with
+// a string less than `prefix`. If `after` is true, keys that start with
+// `prefix` are skipped as well.
+static size_t cli_keys_bound(
+    const struct CliKey* keys, size_t begin, size_t end, size_t offset, const char* prefix,
+    size_t length, bool after
+) {
+    while (begin < end) {
+        size_t middle = begin + (end - begin) / 2;
+        int order = strncmp(keys[middle].name + offset, prefix, length);
+        if (order < 0 || (after && order == 0)) {
+            begin = middle + 1;
+        } else {
+            end = middle;
+        }
+    }
+    return begin;
+}
+#endif // CLI_COMMANDS || CLI_OPTIONS
+
+#ifdef CLI_OPTIONS
+static enum CliError cli_forbid_value(const struct CliOption* option) {
+    if (option->value) {
+        cli_printf_error(
+            "CLI error", "Option '%.*s' does not take a value.", (int)option->key_length,
+            option->key
+        );
+        return CliErrorUser;
+    }
+    return CliErrorOk;
+}
+
+static inline enum CliError cli_set_flag(int* field, const struct CliOption* option) {
+    if (cli_forbid_value(option)) {
+        return CliErrorUser;
+    }
+    *field = 1;
+    return CliErrorOk;
+}
+
+static inline enum CliError cli_set_count(int* field, const struct CliOption* option) {
+    if (cli_forbid_value(option)) {
+        return CliErrorUser;
+    }
+    (*field)++;
+    return CliErrorOk;
+}
+
+// Values are stored by cli_options_parse() once all of them are counted.
+static inline enum CliError
+cli_set_list(struct CliList* field, const struct CliOption* option) {
+    if (cli_require_value(option)) {
+        return CliErrorUser;
+    }
+    field->length++;
+    return CliErrorOk;
+}
+
+#define CLI_FLAG_SET     cli_set_flag
+#define CLI_INT_SET      cli_set_int
+#define CLI_UINT_SET     cli_set_uint
+#define CLI_FLOAT_SET    cli_set_float
+#define CLI_SIZE_SET     cli_set_size
+#define CLI_DURATION_SET cli_set_duration
+#define CLI_STRING_SET   cli_set_string
+#define CLI_COUNT_SET    cli_set_count
+#define CLI_LIST_SET     cli_set_list
+
+#define CLI_FLAG_DEFAULT(field, value)     ((field) = (value))
+#define CLI_INT_DEFAULT(field, value)      ((field) = (value))
+#define CLI_UINT_DEFAULT(field, value)     ((field) = (value))
+#define CLI_FLOAT_DEFAULT(field, value)    ((field) = (value))
+#define CLI_SIZE_DEFAULT(field, value)     ((field) = (value))
+#define CLI_DURATION_DEFAULT(field, value) ((field) = (value))
+#define CLI_STRING_DEFAULT(field, value)   ((field) = (value))
+#define CLI_COUNT_DEFAULT(field, value)    ((field) = (value))
+#define CLI_LIST_DEFAULT(field, value)     ((void)(value), (field).data = NULL, (field).length = 0)
+
+#define CLI_X_KEY(name, alias, kind, default_value) { #name, CliOptionId_##name },
+static struct CliKey cli_option_keys[] = { CLI_OPTIONS(CLI_X_KEY) };
+#undef CLI_X_KEY
+static int cli_option_keys_sorted = 0;
+
+#ifdef CLI_FLAGS
+// Only FLAG and COUNT options can be clustered (`-vv`, `-vn`).
+#define CLI_FLAG_IS_SWITCH     1
+#define CLI_INT_IS_SWITCH      0
+#define CLI_UINT_IS_SWITCH     0
+#define CLI_FLOAT_IS_SWITCH    0
+#define CLI_SIZE_IS_SWITCH     0
+#define CLI_DURATION_IS_SWITCH 0
+#define CLI_STRING_IS_SWITCH   0
+#define CLI_COUNT_IS_SWITCH    1
+#define CLI_LIST_IS_SWITCH     0
+
+// Whether `option` is a cluster of aliases of FLAG and COUNT options, which
+// cli_flags_add() expands into bits as well. A full name takes precedence.
+static bool cli_options_is_cluster(const struct CliOption* option) {
+    if (option->dashes != 1 || option->key_length < 2 || option->value) {
+        return false;
+    }
+    for (CLI_SIZE_T i = 0; i < option->key_length; i++) {
+        bool is_switch = false;
+#define CLI_X_SWITCH(name, alias, kind, default_value) \
+    if ((alias) && option->key[i] == (alias)) {        \
+        is_switch = CLI_##kind##_IS_SWITCH;            \
+    }
+        CLI_OPTIONS(CLI_X_SWITCH)
+#undef CLI_X_SWITCH
+        if (!is_switch) {
+            return false;
+        }
+    }
+    return true;
+}
+#endif // CLI_FLAGS
+
+// Find the option that `option` refers to by its name, its alias or (after
+// two dashes) a unique prefix of its name. With CLI_FLAGS, a cluster of
+// aliases is found as CliOptionIdCount.
+static enum CliError cli_options_find(const struct CliOption* option, enum CliOptionId* id) {
+    size_t length = sizeof(cli_option_keys) / sizeof(cli_option_keys[0]);
+    cli_keys_sort_once(cli_option_keys, length, &cli_option_keys_sorted);
+    size_t first
+        = cli_keys_bound(cli_option_keys, 0, length, 0, option->key, option->key_length, false);
+    size_t last
+        = cli_keys_bound(cli_option_keys, first, length, 0, option->key, option->key_length, true);
+    bool found = option->key_length > 0 && first < last;
+    // The exact name goes before the names that it is a prefix of.
+    if (found && cli_option_keys[first].name[option->key_length] == '\0') {
+        *id = (enum CliOptionId)cli_option_keys[first].id;
+        return CliErrorOk;
+    }
+#ifdef CLI_FLAGS
+    if (cli_options_is_cluster(option)) {
+        *id = CliOptionIdCount;
+        return CliErrorOk;
+    }
+#endif
+
+#define CLI_X_ALIAS(name, alias, kind, default_value)                       \
+    if ((alias) && option->key_length == 1 && option->key[0] == (alias)) { \
+        *id = CliOptionId_##name;                                           \
+        return CliErrorOk;                                                  \
+    }
+    CLI_OPTIONS(CLI_X_ALIAS)
+#undef CLI_X_ALIAS
+
+    if (found && option->dashes == 2) {
+        if (last - first == 1) {
+            *id = (enum CliOptionId)cli_option_keys[first].id;
+            return CliErrorOk;
+        }
+        cli_printf_error(
+            "CLI error", "Ambiguous option '%.*s': it can be '%s' or '%s'.",
+            (int)option->key_length, option->key, cli_option_keys[first].name,
+            cli_option_keys[last - 1].name
+        );
+        return CliErrorUser;
+    }
+    cli_printf_error("CLI error", "Unknown option '%.*s'.", (int)option->key_length, option->key);
+    return CliErrorUser;
+}
+
+// Store `option` to the matching field of `options` and save its identifier
+// to `id`. If it is a LIST option, `list` is set to the field.
+static enum CliError cli_options_set(
+    struct CliOptions* options, const struct CliOption* option, enum CliOptionId* id,
+    struct CliList** list
+) {
+    if (cli_options_find(option, id)) {
+        return CliErrorUser;
+    }
+    switch (*id) {
+#define CLI_X_SET(name, alias, kind, default_value)                                   \
+    case CliOptionId_##name:                                                          \
+        *list = CLI_##kind##_IS_LIST ? (struct CliList*)(void*)&options->name : NULL; \
+        return CLI_##kind##_SET(&options->name, option);
+    CLI_OPTIONS(CLI_X_SET)
+#undef CLI_X_SET
+    default:
+        // A cluster of aliases, which cli_options_parse() expands.
+        *list = NULL;
+        return CliErrorOk;
+    }
+}
+
+#ifdef CLI_FLAGS
+// Set the FLAG and COUNT options of a cluster (see cli_options_is_cluster())
+// one alias at a time.
+static void cli_options_set_cluster(Cli* cli, const struct CliOption* option) {
+    for (CLI_SIZE_T i = 0; i < option->key_length; i++) {
+#define CLI_X_CLUSTER(name, alias, kind, default_value)                    \
+    if (CLI_##kind##_IS_SWITCH && (alias) && option->key[i] == (alias)) { \
+        (void)CLI_##kind##_SET(&cli->options.name, option);               \
+        cli->option_sources[CliOptionId_##name] = option;                 \
+        cli->option_layers[CliOptionId_##name] = CliLayerArgv;            \
+    }
+        CLI_OPTIONS(CLI_X_CLUSTER)
+#undef CLI_X_CLUSTER
+    }
+}
+#endif // CLI_FLAGS
+
+// Store program options of `cli` to `cli->options` in a single pass.
+//
+// Values of LIST options are placed after views (see cli_build_views()) with
+// a counting sort: the list of every option is saved while fields are set,
+// then each list gets a contiguous slice of values in order.
+static enum CliError cli_options_parse(Cli* cli) {
+    const struct CliOption* views = cli->program_option_views;
+    CLI_SIZE_T length = cli->program_options.length;
+    struct CliList** lists = (struct CliList**)(cli->cmd_option_views + cli->cmd_options.length);
+    for (CLI_SIZE_T i = 0; i < length; i++) {
+        struct CliList* list;
+        enum CliOptionId id;
+        if (cli_options_set(&cli->options, &views[i], &id, &list)) {
+            return CliErrorUser;
+        }
+        if (CliOptionListCount) {
+            lists[i] = list;
+        }
+#ifdef CLI_FLAGS
+        if (id == CliOptionIdCount) {
+            cli_options_set_cluster(cli, &views[i]);
+            continue;
+        }
+#endif
+        cli->option_sources[id] = &views[i];
+        cli->option_layers[id] = CliLayerArgv;
+    }
+    if (CliOptionListCount == 0) {
+        return CliErrorOk;
+    }
+
+    const char** values = (const char**)(lists + length);
+#define CLI_X_SLICE(name, alias, kind, default_value)                      \
+    if (CLI_##kind##_IS_LIST) {                                            \
+        struct CliList* list = (struct CliList*)(void*)&cli->options.name; \
+        list->data = values;                                               \
+        values += list->length;                                            \
+        list->length = 0;                                                  \
+    }
+    CLI_OPTIONS(CLI_X_SLICE)
+#undef CLI_X_SLICE
+    for (CLI_SIZE_T i = 0; i < length; i++) {
+        if (lists[i]) {
+            lists[i]->data[lists[i]->length++] = views[i].value;
+        }
+    }
+    return CliErrorOk;
+}
+
+static void cli_options_init(Cli* cli) {
+#define CLI_X_DEFAULT(name, alias, kind, default_value) \
+    CLI_##kind##_DEFAULT(cli->options.name, (default_value));
+    CLI_OPTIONS(CLI_X_DEFAULT)
+#undef CLI_X_DEFAULT
+    for (int i = 0; i < CliOptionIdCount; i++) {
+        cli->option_sources[i] = NULL;
+        cli->option_layers[i] = CliLayerDefault;
+    }
+}
+
+#if defined(CLI_ENV_PREFIX) || defined(CLI_CONFIG_FILES)
+// Values of other layers are always explicit, so FLAG and COUNT options take
+// them as well (`APP_VERBOSE=yes`, `debug = 2`), and a LIST gets one value.
+static inline enum CliError cli_load_flag(int* field, const struct CliOption* option) {
+    static const char* const values[] = { "0", "false", "no", "off", "1", "true", "yes", "on" };
+    if (cli_require_value(option)) {
+        return CliErrorUser;
+    }
+    for (int i = 0; i < 8; i++) {
+        if (strcmp(option->value, values[i]) == 0) {
+            *field = i >= 4;
+            return CliErrorOk;
+        }
+    }
+    return cli_check_value(option, false, "a boolean");
+}
+
+static inline enum CliError cli_load_count(int* field, const struct CliOption* option) {
+    unsigned long long count = 0;
+    if (cli_require_value(option)
+        || cli_check_value(
+            option, cli_str_to_u64(option->value, &count) && count <= 0x7fffffff,
+            "a non-negative integer"
+        )) {
+        return CliErrorUser;
+    }
+    *field = (int)count;
+    return CliErrorOk;
+}
+
+// The list points to the value of the view, which lives as long as the layer.
+static inline enum CliError cli_load_list(struct CliList* field, const struct CliOption* option) {
+    if (cli_require_value(option)) {
+        return CliErrorUser;
+    }
+    field->data = (const char**)&option->value;
+    field->length = 1;
+    return CliErrorOk;
+}
+
+#define CLI_FLAG_LOAD     cli_load_flag
+#define CLI_INT_LOAD      cli_set_int
+#define CLI_UINT_LOAD     cli_set_uint
+#define CLI_FLOAT_LOAD    cli_set_float
+#define CLI_SIZE_LOAD     cli_set_size
+#define CLI_DURATION_LOAD cli_set_duration
+#define CLI_STRING_LOAD   cli_set_string
+#define CLI_COUNT_LOAD    cli_load_count
+#define CLI_LIST_LOAD     cli_load_list
+
+// Set fields of `cli->options` that no layer above `layer` has set from the
+// entries of `index`, which are looked up by full names of options.
+static enum CliError
+cli_options_load(Cli* cli, const struct CliIndex* index, bool fold, enum CliLayer layer) {
+    if (index->capacity == 0) {
+        return CliErrorOk;
+    }
+#define CLI_X_LOAD(name, alias, kind, default_value)                                             \
+    if (cli->option_layers[CliOptionId_##name] <= layer) {                                       \
+        const struct CliOption* option = *cli_index_find(index, #name, sizeof(#name) - 1, fold); \
+        if (option) {                                                                            \
+            if (CLI_##kind##_LOAD(&cli->options.name, option)) {                                 \
+                return CliErrorUser;                                                             \
+            }                                                                                    \
+            cli->option_sources[CliOptionId_##name] = option;                                    \
+            cli->option_layers[CliOptionId_##name] = (unsigned char)layer;                       \
+        }                                                                                        \
+    }
+    CLI_OPTIONS(CLI_X_LOAD)
+#undef CLI_X_LOAD
+    return CliErrorOk;
+}
+#endif // CLI_ENV_PREFIX || CLI_CONFIG_FILES
+
+// Values of options in help text.
+#define CLI_FLAG_METAVAR     ""
+#define CLI_INT_METAVAR      "=INT"
+#define CLI_UINT_METAVAR     "=UINT"
+#define CLI_FLOAT_METAVAR    "=FLOAT"
+#define CLI_SIZE_METAVAR     "=SIZE"
+#define CLI_DURATION_METAVAR "=DURATION"
+#define CLI_STRING_METAVAR   "=STRING"
+#define CLI_COUNT_METAVAR    ""
+#define CLI_LIST_METAVAR     "=VALUE"
+
+// The widest column of options. Descriptions of longer options start on the
+// next line.
+#define CLI_HELP_COLUMN 32
+
+#ifndef CLI_OPTIONS_HELP
+#define CLI_OPTIONS_HELP(X)
+#endif
+
+// An upper bound of the length of help text: a line of each option can take
+// its name, metavar, default value and description, padding to the column,
+// escape sequences of styles (4 of at most 5 bytes) and fixed parts. Strings
+// that are not literals may be longer than their spelling, so the text is
+// truncated to the buffer.
+#define CLI_X_HELP_SIZE(name, alias, kind, default_value)                                     \
+    +sizeof(#name) + sizeof(CLI_##kind##_METAVAR) + sizeof(#default_value) + CliHelpValueSize \
+        + CLI_HELP_COLUMN + 64
+#define CLI_X_HELP_TEXT_SIZE(name, text) +sizeof(text)
+#ifdef CLI_USAGE
+#define CLI_HELP_USAGE_SIZE sizeof(CLI_USAGE)
+#else
+#define CLI_HELP_USAGE_SIZE 0
+#endif
+enum {
+    // Formatted numbers, e.g. `18446744073709551615ms`.
+    CliHelpValueSize = 32,
+    CliHelpSize = 64 + CLI_HELP_USAGE_SIZE CLI_OPTIONS(CLI_X_HELP_SIZE)
+        CLI_OPTIONS_HELP(CLI_X_HELP_TEXT_SIZE)
+};
+#undef CLI_X_HELP_SIZE
+#undef CLI_X_HELP_TEXT_SIZE
+
+static char cli_help[CliHelpSize];
+static size_t cli_help_length = 0;
+// Whether `cli_help` was formatted with styles.
+static bool cli_help_styled = false;
+
+static void cli_help_append(const char* str, size_t length) {
+    if (length > CliHelpSize - cli_help_length) {
+        length = CliHelpSize - cli_help_length;
+    }
+    memcpy(cli_help + cli_help_length, str, length);
+    cli_help_length += length;
+}
+
+static void cli_help_add(const char* str) { cli_help_append(str, strlen(str)); }
+
+static void cli_help_pad(size_t length) {
+    if (length > CliHelpSize - cli_help_length) {
+        length = CliHelpSize - cli_help_length;
+    }
+    memset(cli_help + cli_help_length, ' ', length);
+    cli_help_length += length;
+}
+
+static const char* cli_help_text(enum CliOptionId id) {
+    switch (id) {
+#define CLI_X_HELP_TEXT(name, text) \
+    case CliOptionId_##name:        \
+        return text;
+    CLI_OPTIONS_HELP(CLI_X_HELP_TEXT)
+#undef CLI_X_HELP_TEXT
+    default:
+        return "";
+    }
+}
+
+// Default values are formatted from the values, as they can be expressions or
+// macros. Values that are not shown (NULL or empty strings, FLAG, COUNT and
+// LIST options) are NULL.
+static inline const char* cli_help_int(char* buffer, long long value) {
+    snprintf(buffer, CliHelpValueSize, "%lld", value);
+    return buffer;
+}
+
+static inline const char* cli_help_uint(char* buffer, unsigned long long value, const char* unit) {
+    snprintf(buffer, CliHelpValueSize, "%llu%s", value, unit);
+    return buffer;
+}
+
+static inline const char* cli_help_float(char* buffer, double value) {
+    snprintf(buffer, CliHelpValueSize, "%g", value);
+    return buffer;
+}
+
+static inline const char* cli_help_string(const char* value) {
+    return value && value[0] ? value : NULL;
+}
+
+#define CLI_FLAG_HELP_VALUE(buffer, value)     ((void)(value), (const char*)NULL)
+#define CLI_INT_HELP_VALUE(buffer, value)      cli_help_int(buffer, value)
+#define CLI_UINT_HELP_VALUE(buffer, value)     cli_help_uint(buffer, value, "")
+#define CLI_FLOAT_HELP_VALUE(buffer, value)    cli_help_float(buffer, value)
+#define CLI_SIZE_HELP_VALUE(buffer, value)     cli_help_uint(buffer, value, "")
+#define CLI_DURATION_HELP_VALUE(buffer, value) cli_help_uint(buffer, value, "ms")
+#define CLI_STRING_HELP_VALUE(buffer, value)   cli_help_string(value)
+#define CLI_COUNT_HELP_VALUE(buffer, value)    ((void)(value), (const char*)NULL)
+#define CLI_LIST_HELP_VALUE(buffer, value)     ((void)(value), (const char*)NULL)
+
+// Widen `column` to `width` unless it is wider than CLI_HELP_COLUMN.
+static size_t cli_help_column(size_t column, size_t width) {
+    return width <= CLI_HELP_COLUMN && width > column ? width : column;
+}
+
+// Append a line of an option. `default_value` is NULL if it is not shown.
+static void cli_help_option(
+    const char* name, char alias, const char* metavar, const char* default_value, const char* text,
+    size_t column
+) {
+    const struct CliStyle* style = &cli_stdout_style;
+    cli_help_add("  ");
+    cli_help_add(style->bold);
+    if (alias) {
+        const char short_form[] = { '-', alias, ',', ' ' };
+        cli_help_append(short_form, sizeof(short_form));
+    } else {
+        cli_help_pad(4);
+    }
+    cli_help_add("--");
+    cli_help_add(name);
+    cli_help_add(metavar);
+    cli_help_add(style->reset);
+
+    if (text[0] || default_value) {
+        size_t width = 8 + strlen(name) + strlen(metavar);
+        if (width > column) {
+            cli_help_add("\n");
+            width = 0;
+        }
+        cli_help_pad(column - width + 2);
+        cli_help_add(text);
+    }
+    if (default_value) {
+        cli_help_add(text[0] ? " " : "");
+        cli_help_add(style->dim);
+        cli_help_add("(default: ");
+        cli_help_add(default_value);
+        cli_help_add(")");
+        cli_help_add(style->reset);
+    }
+    cli_help_add("\n");
+}
+
+static void cli_help_format(void) {
+    const struct CliStyle* style = &cli_stdout_style;
+    cli_help_length = 0;
+    cli_help_styled = style->reset[0] != '\0';
+#ifdef CLI_USAGE
+    cli_help_add(style->bold);
+    cli_help_add("Usage:");
+    cli_help_add(style->reset);
+    cli_help_add(" " CLI_USAGE "\n\n");
+#endif
+    cli_help_add(style->bold);
+    cli_help_add("Options:");
+    cli_help_add(style->reset);
+    cli_help_add("\n");
+
+    // `  -v, --name=METAVAR` takes 8 more characters than the name and the
+    // metavar (the sizes of which include the null terminators).
+    size_t column = 0;
+#define CLI_X_HELP_WIDTH(name, alias, kind, default_value) \
+    column = cli_help_column(column, sizeof(#name) + sizeof(CLI_##kind##_METAVAR) + 6);
+    CLI_OPTIONS(CLI_X_HELP_WIDTH)
+#undef CLI_X_HELP_WIDTH
+
+    char value[CliHelpValueSize];
+#define CLI_X_HELP_OPTION(name, alias, kind, default_value)                                  \
+    cli_help_option(                                                                         \
+        #name, (alias), CLI_##kind##_METAVAR, CLI_##kind##_HELP_VALUE(value, default_value), \
+        cli_help_text(CliOptionId_##name), column                                            \
+    );
+    CLI_OPTIONS(CLI_X_HELP_OPTION)
+#undef CLI_X_HELP_OPTION
+}
+
+void cli_print_help(void) {
+    if (cli_help_length == 0 || cli_help_styled != (cli_stdout_style.reset[0] != '\0')) {
+        cli_help_format();
+    }
+    fwrite(cli_help, 1, cli_help_length, stdout);
+}
+#endif // CLI_OPTIONS
+
+#ifdef CLI_FLAGS
+// Set bits of `flags` for every character of a flag cluster, e.g. `-abc`.
+// Options with more than one dash or with a value are not flags.
+static void cli_flags_add(unsigned long long flags[4], const char* option) {
+    if (option[1] == '-') {
+        return;
+    }
+    for (const char* c = option + 1; *c; c++) {
+        if (*c == '=') {
+            return;
+        }
+    }
+    for (const unsigned char* c = (const unsigned char*)option + 1; *c; c++) {
+        flags[*c >> 6] |= 1ull << (*c & 63);
+    }
+}
+#endif // CLI_FLAGS
+
+#ifdef CLI_TOKENIZER
+// Returns the length of the longest prefix of `data` without whitespace,
+// control characters, quotes and backslashes, i.e. bytes that can be copied to
+// a token as they are.
+//
+// Vectorized with SSE2, AVX2 or NEON if available (see CLI_NO_SIMD).
+static size_t cli_scan_plain(const char* data, size_t size) {
+    size_t i = 0;
+#if defined(CLI_SIMD_AVX2)
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i single_quote = _mm256_set1_epi8('\'');
+    const __m256i double_quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    for (; i + 32 <= size; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(data + i));
+        __m256i special = _mm256_or_si256(
+            _mm256_or_si256(
+                _mm256_cmpeq_epi8(_mm256_min_epu8(v, space), v),
+                _mm256_cmpeq_epi8(v, single_quote)
+            ),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, double_quote), _mm256_cmpeq_epi8(v, backslash))
+        );
+        unsigned mask = (unsigned)_mm256_movemask_epi8(special);
+        if (mask) {
+            return i + CLI_CTZ(mask);
+        }
+    }
+#elif defined(CLI_SIMD_SSE2)
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i single_quote = _mm_set1_epi8('\'');
+    const __m128i double_quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    for (; i + 16 <= size; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(data + i));
+        __m128i special = _mm_or_si128(
+            _mm_or_si128(
+                _mm_cmpeq_epi8(_mm_min_epu8(v, space), v), _mm_cmpeq_epi8(v, single_quote)
+            ),
+            _mm_or_si128(_mm_cmpeq_epi8(v, double_quote), _mm_cmpeq_epi8(v, backslash))
+        );
+        unsigned mask = (unsigned)_mm_movemask_epi8(special);
+        if (mask) {
+            return i + CLI_CTZ(mask);
+        }
+    }
+#elif defined(CLI_SIMD_NEON)
+    for (; i + 16 <= size; i += 16) {
+        uint8x16_t v = vld1q_u8((const uint8_t*)(data + i));
+        uint8x16_t special = vorrq_u8(
+            vorrq_u8(vcleq_u8(v, vdupq_n_u8(' ')), vceqq_u8(v, vdupq_n_u8('\''))),
+            vorrq_u8(vceqq_u8(v, vdupq_n_u8('"')), vceqq_u8(v, vdupq_n_u8('\\')))
+        );
+        // Narrow every byte of the mask to 4 bits.
+        unsigned long long mask = vget_lane_u64(
+            vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(special), 4)), 0
+        );
+        if (mask) {
+            return i + (CLI_CTZLL(mask) >> 2);
+        }
+    }
+#endif
+    for (; i < size; i++) {
+        unsigned char c = data[i];
+        if (c <= ' ' || c == '\'' || c == '"' || c == '\\') {
+            break;
+        }
+    }
+    return i;
+}
+
+static bool cli_is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// Split `size` bytes of `data` into tokens in place.
+//
+// Tokens are separated by whitespace. Single quotes preserve everything up to
+// the closing quote, double quotes and no quotes allow escaping a character
+// with a backslash. Tokens are unquoted, NUL-terminated and packed one after
+// another at the start of `data`, so they never take more space than the
+// original text. `data[size]` must be writable for the last NUL.
+//
+// Returns the number of tokens. If the last token has a quote that is not
+// closed, it is saved to `unterminated` (otherwise, it is set to 0).
+static CLI_SIZE_T cli_split_tokens(char* data, size_t size, char* unterminated) {
+    const char* r = data;
+    const char* end = data + size;
+    char* w = data;
+    CLI_SIZE_T length = 0;
+    char quote = 0;
+    while (true) {
+        while (r < end && cli_is_space(*r)) r++;
+        if (r == end) {
+            break;
+        }
+
+        quote = 0;
+        while (r < end && (quote || !cli_is_space(*r))) {
+            // Copy runs of bytes without special meaning at once.
+            size_t n;
+            if (quote == '\'') {
+                const char* close = (const char*)memchr(r, '\'', end - r);
+                n = (close ? close : end) - r;
+            } else {
+                n = cli_scan_plain(r, end - r);
+            }
+            if (n) {
+                if (w != r) memmove(w, r, n);
+                w += n;
+                r += n;
+                continue;
+            }
+
+            if (quote == '\'' && *r == '\'') {
+                quote = 0;
+            } else if (*r == '\\' && r + 1 < end) {
+                *w++ = *++r;
+            } else if (quote && *r == quote) {
+                quote = 0;
+            } else if (!quote && (*r == '\'' || *r == '"')) {
+                quote = *r;
+            } else {
+                *w++ = *r;
+            }
+            r++;
+        }
+        // Consume the separator before it can be overwritten with NUL.
+        if (r < end) r++;
+        *w++ = '\0';
+        length++;
+    }
+    *unterminated = quote;
+    return length;
+}
+#endif // CLI_TOKENIZER
+
+#if defined(CLI_RESPONSE_FILES) || defined(CLI_CONFIG_FILES)
+// Map a file at `path` into private writable memory, so it can be split in
+// place. The mapping (`data` of `size` bytes) is one byte longer than the file.
+static bool cli_map_file(const char* path, char** data, size_t* size) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        return false;
+    }
+    // The file is mapped over anonymous (zero-filled) memory that is one byte
+    // longer, so there is always room for the last NUL, even if the size of
+    // the file is a multiple of the page size.
+    *size = (size_t)st.st_size + 1;
+    *data = (char*)mmap(NULL, *size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (*data == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+    if (st.st_size > 0
+        && mmap(*data, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0)
+            == MAP_FAILED) {
+        munmap(*data, *size);
+        close(fd);
+        return false;
+    }
+    close(fd);
+    return true;
+}
+#endif // CLI_RESPONSE_FILES || CLI_CONFIG_FILES
+
+#ifdef CLI_RESPONSE_FILES
+static bool cli_is_response_file(const char* arg) {
+    return arg[0] == '@' && arg[1] != '\0';
+}
+
+// Map a file at `path` into memory and split it into tokens.
+static enum CliError cli_map_response_file(const char* path, struct CliResponseFile* file) {
+    if (!cli_map_file(path, &file->data, &file->size)) {
+        cli_printf_error("CLI error", "Unable to read the response file ('%s').", path);
+        return CliErrorUser;
+    }
+    char quote;
+    file->length = cli_split_tokens(file->data, file->size - 1, &quote);
+    if (quote) {
+        munmap(file->data, file->size);
+        cli_printf_error(
+            "CLI error", "Unterminated quote (%c) in the response file ('%s').", quote, path
+        );
+        return CliErrorUser;
+    }
+    return CliErrorOk;
+}
+
+// Map all response files of argv and add the number of their tokens to `total`.
+static enum CliError cli_load_response_files(Cli* cli, int argc, char** argv, CLI_SIZE_T* total) {
+    cli->response_files = NULL;
+    cli->response_files_length = 0;
+
+    CLI_SIZE_T count = 0;
+    for (int i = 0; i < argc; i++) count += cli_is_response_file(argv[i]);
+    if (count == 0) {
+        return CliErrorOk;
+    }
+
+    cli->response_files
+        = (struct CliResponseFile*)CLI_MALLOC(count * sizeof(struct CliResponseFile));
+    if (cli->response_files == NULL) {
+        cli_print_error("Memory error", "Unable to allocate memory for response files.");
+        return CliErrorFatal;
+    }
+    for (int i = 0; i < argc; i++) {
+        if (!cli_is_response_file(argv[i])) {
+            continue;
+        }
+        struct CliResponseFile* file = &cli->response_files[cli->response_files_length];
+        enum CliError error = cli_map_response_file(argv[i] + 1, file);
+        if (error) {
+            return error;
+        }
+        cli->response_files_length++;
+        // The token of the response file itself is replaced with its tokens.
+        *total = *total - 1 + file->length;
+    }
+    // The block is counted once all files are mapped, as cli_stats() takes
+    // the number of mapped files as its size.
+    cli_stats_add(cli, NULL, cli->response_files, count * sizeof(struct CliResponseFile));
+    return CliErrorOk;
+}
+#endif // CLI_RESPONSE_FILES
+
+#ifdef CLI_CONFIG_FILES
+// Split `size` bytes of a mapped config file into entries in place.
+//
+// Keys are not NUL-terminated (like keys of options), while values are
+// unquoted by cli_split_tokens(), which may overwrite the end of the line.
+static enum CliError cli_split_config(struct CliConfigFile* file, const char* path, size_t size) {
+    char* end = file->data + size;
+    size_t number = 0;
+    for (char* line = file->data; line < end; number++) {
+        char* eol = (char*)memchr(line, '\n', end - line);
+        eol = eol ? eol : end;
+        char* c = line;
+        line = eol + 1;
+        while (c < eol && cli_is_space(*c)) c++;
+        if (c == eol || *c == '#' || *c == ';') {
+            continue;
+        }
+
+        struct CliOption* entry = &file->views[file->length];
+        entry->dashes = 0;
+        entry->key = c;
+        while (c < eol && *c != '=' && !cli_is_space(*c)) c++;
+        entry->key_length = c - entry->key;
+        while (c < eol && cli_is_space(*c)) c++;
+        if (entry->key_length == 0 || c == eol || *c != '=') {
+            cli_printf_error(
+                "CLI error", "Expected 'key = value' on line %zu of the config file ('%s').",
+                number + 1, path
+            );
+            return CliErrorUser;
+        }
+        c++;
+        char quote;
+        CLI_SIZE_T tokens = cli_split_tokens(c, eol - c, &quote);
+        if (quote) {
+            cli_printf_error(
+                "CLI error", "Unterminated quote (%c) on line %zu of the config file ('%s').",
+                quote, number + 1, path
+            );
+            return CliErrorUser;
+        }
+        if (tokens > 1) {
+            cli_printf_error(
+                "CLI error", "The value on line %zu of the config file ('%s') should be quoted.",
+                number + 1, path
+            );
+            return CliErrorUser;
+        }
+        if (tokens == 0) {
+            *c = '\0';
+        }
+        entry->value = c;
+        file->length++;
+    }
+    return CliErrorOk;
+}
+
+enum CliError cli_load_config(Cli* cli, const char* path) {
+    struct CliConfigFile file = CLI_ZERO;
+    if (!cli_map_file(path, &file.data, &file.size)) {
+        cli_printf_error("CLI error", "Unable to read the config file ('%s').", path);
+        return CliErrorUser;
     }
+    // Every entry takes a line, so lines are counted to allocate all views at
+    // once.
+    size_t size = file.size - 1;
+    CLI_SIZE_T lines = 1;
+    for (const char* c = file.data; (c = (const char*)memchr(c, '\n', file.data + size - c)); c++) {
+        lines++;
+    }
+
+    file.views = (struct CliOption*)CLI_MALLOC(lines * CLI_ENV_VIEW_SIZE);
+    cli_stats_add(cli, NULL, file.views, lines * CLI_ENV_VIEW_SIZE);
+    file.capacity = lines;
+    size_t files_size = (cli->config_files_length + 1) * sizeof(struct CliConfigFile);
+    struct CliConfigFile* files
+        = (struct CliConfigFile*)CLI_REALLOC(cli->config_files, files_size);
+    cli_stats_add(cli, cli->config_files, files, files_size);
+    if (files) {
+        cli->config_files = files;
+    }
+    if (file.views == NULL || files == NULL) {
+        CLI_FREE(file.views);
+        munmap(file.data, file.size);
+        cli_print_error("Memory error", "Unable to allocate memory for the config file.");
+        return CliErrorFatal;
+    }
+
+    enum CliError error = cli_split_config(&file, path, size);
+    if (error) {
+        CLI_FREE(file.views);
+        munmap(file.data, file.size);
+        return error;
+    }
+    cli_index_build(
+        &file.index, file.views, file.length, (const struct CliOption**)(file.views + lines), false
+    );
+    cli->config_files[cli->config_files_length++] = file;
+#ifdef CLI_OPTIONS
+    return cli_options_load(cli, &file.index, false, CliLayerConfig);
+#else
+    return CliErrorOk;
 #endif
+}
 
-#ifndef cli_da_append
-#define cli_da_append(array, item)                                                           \
-    {                                                                                        \
-        if (++(array).length > (array).capacity) {                                           \
-            (array).capacity *= 2;                                                           \
-            (array).data                                                                     \
-                = (typeof(item)*)CLI_REALLOC((array).data, (array).capacity * sizeof(item)); \
-            if ((array).data == NULL) {                                                      \
-                cli_print_error(                                                             \
-                    "Memory error", "Unable to reallocate memory for more array items."      \
-                );                                                                           \
-                CLI_ASSERT(0 && "Memory error");                                             \
-            }                                                                                \
-        }                                                                                    \
-        (array).data[(array).length - 1] = (item);                                           \
+static void cli_unload_config_files(Cli* cli) {
+    for (CLI_SIZE_T i = 0; i < cli->config_files_length; i++) {
+        munmap(cli->config_files[i].data, cli->config_files[i].size);
+        CLI_FREE(cli->config_files[i].views);
     }
+    CLI_FREE(cli->config_files);
+    cli->config_files = NULL;
+    cli->config_files_length = 0;
+}
+#endif // CLI_CONFIG_FILES
+
+// Tokens of the command line in order, with response files expanded.
+struct CliTokens {
+    int argc;
+    char** argv;
+#ifdef CLI_RESPONSE_FILES
+    // The next response file to expand.
+    const struct CliResponseFile* file;
 #endif
+#ifdef CLI_TOKENIZER
+    // The next token split by cli_split_tokens().
+    const char* next;
+    CLI_SIZE_T left;
+#endif
+};
 
-static const char* cli_pop_argv(int* argc, char*** argv) {
-    CLI_ASSERT(*argc);
-    (*argc)--;
-    return *((*argv)++);
+// Returns NULL after the last token.
+static const char* cli_tokens_next(struct CliTokens* tokens) {
+#ifdef CLI_TOKENIZER
+    while (tokens->left == 0) {
+        if (tokens->argc == 0) {
+            return NULL;
+        }
+        const char* arg = cli_pop_argv(&tokens->argc, &tokens->argv);
+#ifdef CLI_RESPONSE_FILES
+        if (cli_is_response_file(arg)) {
+            tokens->next = tokens->file->data;
+            tokens->left = tokens->file->length;
+            tokens->file++;
+            continue;
+        }
+#endif
+        return arg;
+    }
+    const char* token = tokens->next;
+    tokens->next += strlen(token) + 1;
+    tokens->left--;
+    return token;
+#else
+    return tokens->argc ? cli_pop_argv(&tokens->argc, &tokens->argv) : NULL;
+#endif // CLI_TOKENIZER
 }
 
-enum CliError cli_parse(int argc, char** argv, Cli* cli) {
-    const char* execfile = cli_pop_argv(&argc, &argv);
-    if (argc > 0) {
-        cli->execfile = execfile;
-        cli_da_init(cli->args, const char*, CLI_MALLOC);
+#ifdef CLI_COMMANDS
+#define CLI_X_COMMAND_KEY(name, path) { path, CliCommandId_##name },
+static struct CliKey cli_commands[] = { CLI_COMMANDS(CLI_X_COMMAND_KEY) };
+#undef CLI_X_COMMAND_KEY
+static int cli_commands_sorted = 0;
+
+// Find the command that leading positional arguments of `tokens` start with,
+// and the number of its words.
+static enum CliError
+cli_find_command(struct CliTokens tokens, enum CliCommandId* command, CLI_SIZE_T* words) {
+    cli_keys_sort_once(
+        cli_commands, sizeof(cli_commands) / sizeof(cli_commands[0]), &cli_commands_sorted
+    );
+    *command = CliCommandIdNone;
+    *words = 0;
+
+    // Commands in [begin, end) start with `offset` bytes of `matched` words.
+    size_t begin = 0, end = sizeof(cli_commands) / sizeof(cli_commands[0]), offset = 0;
+    CLI_SIZE_T matched = 0;
+    const char* arg;
+    while (begin < end && (arg = cli_tokens_next(&tokens))) {
+        if (arg[0] == '-') {
+            // Options after a word are command options.
+            if (matched || (arg[1] == '-' && arg[2] == '\0')) {
+                break;
+            }
+            continue;
+        }
+        // Words of paths cannot contain spaces.
+        size_t length = strcspn(arg, " ");
+        if (length == 0 || arg[length] != '\0') {
+            break;
+        }
+        size_t first = cli_keys_bound(cli_commands, begin, end, offset, arg, length, false);
+        size_t last = cli_keys_bound(cli_commands, first, end, offset, arg, length, true);
+        if (first == last) {
+            break;
+        }
+
+        // Names that end with `arg` or continue it with a space go before the
+        // others, so a complete word is always preferred to longer ones.
+        const char* word = cli_commands[first].name + offset;
+        if (word[length] != '\0' && word[length] != ' ') {
+            length = strcspn(word, " ");
+            const char* other = cli_commands[last - 1].name + offset;
+            if (strncmp(word, other, length) != 0
+                || (other[length] != '\0' && other[length] != ' ')) {
+                cli_printf_error(
+                    "CLI error", "Ambiguous command ('%s'): it can be '%.*s' or '%.*s'.", arg,
+                    (int)length, word, (int)strcspn(other, " "), other
+                );
+                return CliErrorUser;
+            }
+        }
+
+        matched++;
+        begin = first;
+        if (word[length] == '\0') {
+            *command = (enum CliCommandId)cli_commands[first].id;
+            *words = matched;
+            begin++;
+        }
+        // Longer paths continue the word with a space.
+        end = begin;
+        if (begin < last && cli_commands[begin].name[offset + length] == ' ') {
+            end = cli_keys_bound(
+                cli_commands, begin, last, offset, cli_commands[begin].name + offset,
+                length + 1, true
+            );
+        }
+        offset += length + 1;
+    }
+    return CliErrorOk;
+}
+
+// Words of the command are classified as positional arguments, but skipped.
+static bool
+cli_skip_command(struct CliClassifier* state, enum CliToken token, CLI_SIZE_T* words) {
+    if (token != CliTokenArgument || *words == 0) {
+        return false;
+    }
+    (*words)--;
+    // Allow `--` right after the command.
+    state->last_arg = NULL;
+    return true;
+}
+#endif // CLI_COMMANDS
+
+// Parse `total` tokens into arrays with the given initial capacities (indexed
+// by `enum CliToken`).
+//
+// If `capacity` is NULL, tokens are counted in advance and used as capacities.
+//
+// `cli` should be empty (see cli_reset()), but its buffers are reused.
+static enum CliError cli_parse_tokens(
+    struct CliTokens tokens, CLI_SIZE_T total, Cli* cli, const CLI_SIZE_T* capacity
+) {
+#ifdef CLI_ENV_PREFIX
+    if (cli_build_env(cli)) {
+        return CliErrorFatal;
+    }
+#endif
+    if (total > 0) {
+        const char* arg;
+        enum CliToken token;
+#ifdef CLI_COMMANDS
+        CLI_SIZE_T words;
+        if (cli_find_command(tokens, &cli->command, &words)) {
+            return CliErrorUser;
+        }
+#endif
+        CLI_SIZE_T exact[CliTokenDoubleDash];
+        if (capacity == NULL) {
+            CLI_SIZE_T count[CliTokenDoubleDash + 1] = { 0 };
+            struct CliClassifier state = CLI_ZERO;
+            struct CliTokens counted = tokens;
+#ifdef CLI_COMMANDS
+            CLI_SIZE_T counted_words = words;
+#endif
+            while ((arg = cli_tokens_next(&counted))) {
+                if (cli_classify(&state, arg, &token)) {
+                    return CliErrorUser;
+                }
+#ifdef CLI_COMMANDS
+                if (cli_skip_command(&state, token, &counted_words)) {
+                    continue;
+                }
+#endif
+                count[token]++;
+            }
+
+            // Empty arrays still get one item, so a failed allocation can be
+            // told apart from an empty array.
+            for (int i = 0; i < CliTokenDoubleDash; i++) {
+                exact[i] = count[i] ? count[i] : 1;
+            }
+            capacity = exact;
+        }
+#if defined(CLI_NOHEAP) || defined(CLI_ARENA)
+        (void)capacity;
+#endif
+
+#ifdef CLI_ARENA
+        // `--` is never stored, so `total` pointers are always enough.
+        if (cli->arena_capacity < total) {
+            CLI_FREE(cli->arena);
+            cli->arena = (const char**)CLI_MALLOC(total * sizeof(const char*));
+            cli_stats_add(cli, NULL, cli->arena, total * sizeof(const char*));
+            cli->arena_capacity = cli->arena ? total : 0;
+        }
+#else
+        (void)total;
+#endif
+        cli_da_init(cli->args, const char*, CLI_MALLOC, capacity[CliTokenArgument]);
         if (cli->args.data == NULL) {
             cli_print_error("Memory error", "Unable to allocate memory for CLI arguments.");
             return CliErrorFatal;
         }
-        cli_da_init(cli->cmd_options, const char*, CLI_MALLOC);
+        cli_da_init(cli->cmd_options, const char*, CLI_MALLOC, capacity[CliTokenCmdOption]);
         if (cli->cmd_options.data == NULL) {
             cli_print_error("Memory error", "Unable to allocate memory for command options.");
             return CliErrorFatal;
         }
-        cli_da_init(cli->program_options, const char*, CLI_MALLOC);
+        cli_da_init(
+            cli->program_options, const char*, CLI_MALLOC, capacity[CliTokenProgramOption]
+        );
         if (cli->program_options.data == NULL) {
             cli_print_error("Memory error", "Unable to allocate memory for program options.");
             return CliErrorFatal;
         }
 
-        const char* arg;
-        bool is_cmd_option = false;
-        while (argc) {
-            arg = cli_pop_argv(&argc, &argv);
-            if (arg[0] == '-') {
-                struct CliArray* option_array
-                    = is_cmd_option ? &cli->cmd_options : &cli->program_options;
-
-                if (arg[1] == '-' && arg[2] == '\0') {
-                    if (cli->args.length > 0) {
-                        cli_printf_error(
-                            "CLI error",
-                            "Double dash ('%s') cannot be specified after the positional argument "
-                            "('%s').",
-                            arg, *(char**)(&cli->args.data[cli->args.length - 1])
-                        );
-                        return CliErrorUser;
-                    }
-                    is_cmd_option = true;
-                } else {
-                    cli_da_append(*option_array, arg);
-                }
-            } else {
-                if (cli->cmd_options.length > 0) {
-                    cli_printf_error(
-                        "CLI error",
-                        "Positional arguments ('%s') should be specified prior to command options.",
-                        arg
-                    );
-                    return CliErrorUser;
-                }
-                cli_da_append(cli->args, arg);
-                is_cmd_option = true;
+        struct CliClassifier state = CLI_ZERO;
+        while ((arg = cli_tokens_next(&tokens))) {
+            if (cli_classify(&state, arg, &token)) {
+                return CliErrorUser;
+            }
+#ifdef CLI_COMMANDS
+            if (cli_skip_command(&state, token, &words)) {
+                continue;
+            }
+#endif
+            if (token != CliTokenDoubleDash) {
+                cli_da_append(*cli_bucket(cli, token), arg);
             }
+#ifdef CLI_FLAGS
+            if (token == CliTokenProgramOption) {
+                cli_flags_add(cli->program_flags, arg);
+            } else if (token == CliTokenCmdOption) {
+                cli_flags_add(cli->cmd_flags, arg);
+            }
+#endif
         }
-    } else {
-        *cli = (struct Cli) { 0 };
-        cli->execfile = execfile;
+
+#ifdef CLI_OPTION_VIEWS
+        if (cli_build_views(cli)) {
+            return CliErrorFatal;
+        }
+#endif
+#ifdef CLI_OPTIONS
+        if (cli_options_parse(cli)) {
+            return CliErrorUser;
+        }
+#endif
+    }
+#if defined(CLI_OPTIONS) && defined(CLI_ENV_PREFIX)
+    if (cli_options_load(cli, &cli->env_index, true, CliLayerEnv)) {
+        return CliErrorUser;
     }
+#endif
     return CliErrorOk;
 }
 
+// Parse the command line (after the executable file) with cli_parse_tokens().
+static enum CliError cli_parse_sized(int argc, char** argv, Cli* cli, const CLI_SIZE_T* capacity) {
+    cli->execfile = cli_pop_argv(&argc, &argv);
+
+    struct CliTokens tokens = CLI_ZERO;
+    tokens.argc = argc;
+    tokens.argv = argv;
+    CLI_SIZE_T total = argc;
+#ifdef CLI_RESPONSE_FILES
+    enum CliError error = cli_load_response_files(cli, argc, argv, &total);
+    if (error) {
+        return error;
+    }
+    tokens.file = cli->response_files;
+#endif
+    return cli_parse_tokens(tokens, total, cli, capacity);
+}
+
+#ifdef CLI_RESPONSE_FILES
+// Mappings cannot be reused, as they have the size of their files.
+static void cli_unload_response_files(Cli* cli) {
+    for (CLI_SIZE_T i = 0; i < cli->response_files_length; i++) {
+        munmap(cli->response_files[i].data, cli->response_files[i].size);
+    }
+    CLI_FREE(cli->response_files);
+    cli->response_files = NULL;
+    cli->response_files_length = 0;
+}
+#endif // CLI_RESPONSE_FILES
+
+void cli_reset(Cli* cli) {
+#ifdef CLI_STATS
+    cli->stats.peak = cli_stats(cli).peak;
+#endif
+#ifdef CLI_RESPONSE_FILES
+    cli_unload_response_files(cli);
+#endif
+#ifdef CLI_CONFIG_FILES
+    cli_unload_config_files(cli);
+#endif
+    cli->args.length = 0;
+    cli->cmd_options.length = 0;
+    cli->program_options.length = 0;
+#ifdef CLI_INDEX
+    cli->cmd_index.capacity = cli->program_index.capacity = 0;
+#endif
+#ifdef CLI_ENV_PREFIX
+    cli->env_index.capacity = 0;
+#endif
+#ifdef CLI_FLAGS
+    for (int i = 0; i < 4; i++) cli->cmd_flags[i] = cli->program_flags[i] = 0;
+#endif
+#ifdef CLI_OPTIONS
+    cli_options_init(cli);
+#endif
+#ifdef CLI_COMMANDS
+    cli->command = CliCommandIdNone;
+#endif
+}
+
+enum CliError cli_parse(int argc, char** argv, Cli* cli) {
+    const CLI_SIZE_T capacity[CliTokenDoubleDash]
+        = { CLI_DEFAULT_ARR_CAP, CLI_DEFAULT_ARR_CAP, CLI_DEFAULT_ARR_CAP };
+#ifndef CLI_NOHEAP
+    // Otherwise, `cli` is prepared by cli_parse_noheap().
+    *cli = CLI_ZERO_LITERAL(struct Cli);
+#endif
+    cli_reset(cli);
+    return cli_parse_sized(argc, argv, cli, capacity);
+}
+
+#ifndef CLI_NOHEAP
+enum CliError cli_parse_exact(int argc, char** argv, Cli* cli) {
+#ifdef CLI_ARENA
+    return cli_parse(argc, argv, cli);
+#else
+    *cli = CLI_ZERO_LITERAL(struct Cli);
+    cli_reset(cli);
+    return cli_parse_sized(argc, argv, cli, NULL);
+#endif
+}
+
+enum CliError cli_parse_into(int argc, char** argv, Cli* cli) {
+    const CLI_SIZE_T capacity[CliTokenDoubleDash]
+        = { CLI_DEFAULT_ARR_CAP, CLI_DEFAULT_ARR_CAP, CLI_DEFAULT_ARR_CAP };
+    cli_reset(cli);
+    return cli_parse_sized(argc, argv, cli, capacity);
+}
+
+enum CliError cli_parse_line(char* line, Cli* cli) {
+    const CLI_SIZE_T capacity[CliTokenDoubleDash]
+        = { CLI_DEFAULT_ARR_CAP, CLI_DEFAULT_ARR_CAP, CLI_DEFAULT_ARR_CAP };
+    cli_reset(cli);
+    cli->execfile = NULL;
+
+    struct CliTokens tokens = CLI_ZERO;
+    tokens.next = line;
+    char quote;
+    tokens.left = cli_split_tokens(line, strlen(line), &quote);
+    if (quote) {
+        cli_printf_error("CLI error", "Unterminated quote (%c) in the command line.", quote);
+        return CliErrorUser;
+    }
+    return cli_parse_tokens(tokens, tokens.left, cli, capacity);
+}
+#endif // CLI_NOHEAP
+
+// Pass `arg` to `callback` unless it is `--`.
+static enum CliError cli_each_token(
+    struct CliClassifier* state, const char* arg, CliCallback callback, void* userdata
+) {
+    enum CliToken token;
+    if (cli_classify(state, arg, &token)) {
+        return CliErrorUser;
+    }
+    return token == CliTokenDoubleDash ? CliErrorOk : callback(token, arg, userdata);
+}
+
+enum CliError cli_parse_each(int argc, char** argv, CliCallback callback, void* userdata) {
+    cli_pop_argv(&argc, &argv);
+
+    struct CliClassifier state = CLI_ZERO;
+    enum CliError error = CliErrorOk;
+    while (argc > 0 && !error) {
+        const char* arg = cli_pop_argv(&argc, &argv);
+#ifdef CLI_RESPONSE_FILES
+        if (cli_is_response_file(arg)) {
+            struct CliResponseFile file;
+            if (cli_map_response_file(arg + 1, &file)) {
+                return CliErrorUser;
+            }
+            const char* token = file.data;
+            for (CLI_SIZE_T i = 0; i < file.length && !error; i++) {
+                error = cli_each_token(&state, token, callback, userdata);
+                token += strlen(token) + 1;
+            }
+            munmap(file.data, file.size);
+            continue;
+        }
+#endif
+        error = cli_each_token(&state, arg, callback, userdata);
+    }
+    return error;
+}
+
+#ifdef CLI_STATS
+struct CliStats cli_stats(const Cli* cli) {
+    struct CliStats stats = cli->stats;
+#if defined(CLI_ARENA)
+    stats.current = cli->arena_capacity * sizeof(const char*);
+#elif !defined(CLI_NOHEAP)
+    stats.current = (cli->args.capacity + cli->cmd_options.capacity + cli->program_options.capacity)
+        * sizeof(const char*);
+#endif
+#if defined(CLI_OPTION_VIEWS) && !defined(CLI_NOHEAP)
+    stats.current += cli->option_views_capacity * CLI_OPTION_VIEW_SIZE;
+#endif
+#ifdef CLI_RESPONSE_FILES
+    stats.current += cli->response_files_length * sizeof(struct CliResponseFile);
+#endif
+#ifdef CLI_ENV_PREFIX
+    stats.current += cli->env_capacity * CLI_ENV_VIEW_SIZE;
+#endif
+#ifdef CLI_CONFIG_FILES
+    for (CLI_SIZE_T i = 0; i < cli->config_files_length; i++) {
+        stats.current += cli->config_files[i].capacity * CLI_ENV_VIEW_SIZE;
+    }
+    stats.current += cli->config_files_length * sizeof(struct CliConfigFile);
+#endif
+    // Blocks only grow until cli_free(), except for response files.
+    if (stats.current > stats.peak) {
+        stats.peak = stats.current;
+    }
+    return stats;
+}
+
+void cli_print_stats(const Cli* cli) {
+    struct CliStats stats = cli_stats(cli);
+    cli_printf_info(
+        "Memory",
+        "%zu allocations, %zu reallocations, %zu bytes requested, %zu bytes held (%zu at peak).",
+        stats.allocations, stats.reallocations, stats.bytes, stats.current, stats.peak
+    );
+}
+#endif // CLI_STATS
+
 inline void cli_free(Cli* cli) {
-#ifdef CLI_NOHEAP
+#ifdef CLI_RESPONSE_FILES
+    cli_unload_response_files(cli);
+#endif
+#ifdef CLI_CONFIG_FILES
+    cli_unload_config_files(cli);
+#endif
+#if defined(CLI_OPTION_VIEWS) && !defined(CLI_NOHEAP)
+    // All views and tables share the same block.
+    CLI_FREE(cli->program_option_views);
+#endif
+#ifdef CLI_ENV_PREFIX
+    CLI_FREE(cli->env_views);
+#endif
+#if defined(CLI_NOHEAP)
     (void)cli;
+#elif defined(CLI_ARENA)
+    CLI_FREE(cli->arena);
 #else
     CLI_FREE(cli->args.data);
     CLI_FREE(cli->cmd_options.data);
@@ -450,4 +3616,262 @@ inline void cli_free(Cli* cli) {
 }
 #endif
 
+#if defined(CLI_CPP) && defined(__cplusplus)
+#if __cplusplus < 201703L && (!defined(_MSVC_LANG) || _MSVC_LANG < 201703L)
+#error "CLI_CPP requires C++17."
+#endif
+
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+
+namespace cli {
+
+// A random-access range of tokens (e.g. Cli.args) as std::string_view. It
+// points to the array of `const char*`, so it is valid as long as the array
+// is, and every token is measured when it is accessed.
+class Tokens {
+public:
+    class iterator {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = std::string_view;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = std::string_view;
+
+        constexpr iterator() noexcept = default;
+        constexpr explicit iterator(const char* const* token) noexcept : token(token) {}
+
+        constexpr std::string_view operator*() const noexcept { return *token; }
+        constexpr std::string_view operator[](difference_type n) const noexcept {
+            return token[n];
+        }
+
+        constexpr iterator& operator++() noexcept { return ++token, *this; }
+        constexpr iterator& operator--() noexcept { return --token, *this; }
+        constexpr iterator operator++(int) noexcept { return iterator(token++); }
+        constexpr iterator operator--(int) noexcept { return iterator(token--); }
+        constexpr iterator& operator+=(difference_type n) noexcept { return token += n, *this; }
+        constexpr iterator& operator-=(difference_type n) noexcept { return token -= n, *this; }
+
+        friend constexpr iterator operator+(iterator it, difference_type n) noexcept {
+            return it += n;
+        }
+        friend constexpr iterator operator+(difference_type n, iterator it) noexcept {
+            return it += n;
+        }
+        friend constexpr iterator operator-(iterator it, difference_type n) noexcept {
+            return it -= n;
+        }
+        friend constexpr difference_type operator-(iterator a, iterator b) noexcept {
+            return a.token - b.token;
+        }
+        friend constexpr bool operator==(iterator a, iterator b) noexcept {
+            return a.token == b.token;
+        }
+        friend constexpr bool operator!=(iterator a, iterator b) noexcept {
+            return a.token != b.token;
+        }
+        friend constexpr bool operator<(iterator a, iterator b) noexcept {
+            return a.token < b.token;
+        }
+        friend constexpr bool operator>(iterator a, iterator b) noexcept { return b < a; }
+        friend constexpr bool operator<=(iterator a, iterator b) noexcept { return !(b < a); }
+        friend constexpr bool operator>=(iterator a, iterator b) noexcept { return !(a < b); }
+
+    private:
+        const char* const* token = nullptr;
+    };
+
+    constexpr Tokens() noexcept = default;
+    constexpr Tokens(const char* const* data, CLI_SIZE_T length) noexcept
+        : tokens(data)
+        , length(length) {}
+    constexpr Tokens(const CliArray& array) noexcept
+        : Tokens(array.data, array.length) {}
+#ifdef CLI_OPTIONS
+    constexpr Tokens(const CliList& list) noexcept
+        : Tokens(list.data, list.length) {}
+#endif
+
+    constexpr iterator begin() const noexcept { return iterator(tokens); }
+    constexpr iterator end() const noexcept { return iterator(tokens + length); }
+    constexpr CLI_SIZE_T size() const noexcept { return length; }
+    constexpr bool empty() const noexcept { return length == 0; }
+    constexpr const char* const* data() const noexcept { return tokens; }
+    constexpr std::string_view operator[](CLI_SIZE_T i) const noexcept { return tokens[i]; }
+    constexpr std::string_view front() const noexcept { return tokens[0]; }
+    constexpr std::string_view back() const noexcept { return tokens[length - 1]; }
+
+private:
+    const char* const* tokens = nullptr;
+    CLI_SIZE_T length = 0;
+};
+
+#ifdef CLI_OPTIONS
+// The identifier of the option `name` of CLI_OPTIONS, or CliOptionIdCount if
+// there is no such option. Usable in constant expressions, e.g. in `case`
+// labels and static_assert().
+constexpr CliOptionId option_id(std::string_view name) noexcept {
+#define CLI_X_CPP_ID(name_, alias, kind, default_value) \
+    if (name == #name_) {                               \
+        return CliOptionId_##name_;                     \
+    }
+    CLI_OPTIONS(CLI_X_CPP_ID)
+#undef CLI_X_CPP_ID
+    return CliOptionIdCount;
+}
+#endif
+
+namespace detail {
+// Check whether the number `value` is in the range of the arithmetic type `T`.
+template <class T, class V> constexpr bool fits(V value) noexcept {
+    if constexpr (std::is_same_v<T, bool>) {
+        return true;
+    } else if constexpr (std::is_floating_point_v<T>) {
+        // Integers only lose precision, and NaN is kept.
+        return std::is_integral_v<V>
+            || !(value > std::numeric_limits<T>::max() || value < -std::numeric_limits<T>::max());
+    } else if constexpr (std::is_floating_point_v<V>) {
+        // The maximum of `T` + 1 is a power of two, so it is exact as V.
+        constexpr V limit = static_cast<V>(std::numeric_limits<T>::max() / 2 + 1) * 2;
+        return value >= static_cast<V>(std::numeric_limits<T>::min()) && value < limit;
+    } else {
+        if constexpr (std::is_signed_v<V>) {
+            if (value < 0) {
+                return std::is_signed_v<T>
+                    && static_cast<long long>(value)
+                    >= static_cast<long long>(std::numeric_limits<T>::min());
+            }
+        }
+        return static_cast<unsigned long long>(value)
+            <= static_cast<unsigned long long>(std::numeric_limits<T>::max());
+    }
+}
+
+// Convert `value` to `T`, or return std::nullopt if it does not fit.
+template <class T, class V> constexpr std::optional<T> narrow(V value) noexcept {
+    return fits<T>(value) ? std::optional<T>(static_cast<T>(value)) : std::nullopt;
+}
+
+#ifdef CLI_OPTIONS
+// Convert a field of CliOptions to `T`, or return std::nullopt if `T` cannot
+// hold the kind of the option or its value (or a STRING option is NULL).
+template <class T, class Field>
+constexpr std::optional<T> convert(const Field& field) noexcept {
+    if constexpr (std::is_arithmetic_v<T> && std::is_arithmetic_v<Field>) {
+        return narrow<T>(field);
+    } else if constexpr (
+        std::is_same_v<T, std::string_view> && std::is_same_v<Field, const char*>
+    ) {
+        return field ? std::optional<T>(field) : std::nullopt;
+    } else if constexpr (std::is_same_v<T, Tokens> && std::is_same_v<Field, CliList>) {
+        return Tokens(field);
+    } else {
+        return std::nullopt;
+    }
+}
+#endif
+
+#ifdef CLI_INDEX
+// Look up the program option `key` with cli_get_option() and convert it to
+// `bool`, a number or std::string_view, or return std::nullopt for other types.
+template <class T> std::optional<T> lookup(const ::Cli& cli, const char* key) noexcept {
+    const char* value = cli_get_option(&cli, key);
+    if constexpr (std::is_same_v<T, bool>) {
+        return value != nullptr;
+    } else if (value == nullptr) {
+        return std::nullopt;
+    } else if constexpr (std::is_same_v<T, std::string_view>) {
+        return std::string_view(value);
+    } else if constexpr (std::is_floating_point_v<T>) {
+        double result;
+        return cli_get_f64(&cli, key, &result) ? std::nullopt : narrow<T>(result);
+    } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+        long long result;
+        return cli_get_i64(&cli, key, &result) ? std::nullopt : narrow<T>(result);
+    } else if constexpr (std::is_integral_v<T>) {
+        unsigned long long result;
+        return cli_get_u64(&cli, key, &result) ? std::nullopt : narrow<T>(result);
+    } else {
+        return std::nullopt;
+    }
+}
+#endif
+} // namespace detail
+
+// An owner of Cli that frees it when it is destroyed. It makes no allocations
+// beyond those of cli_parse().
+class Parser {
+public:
+    Parser() noexcept
+        : cli() {}
+    ~Parser() { cli_free(&cli); }
+    Parser(const Parser&) = delete;
+    Parser& operator=(const Parser&) = delete;
+
+    // cli_parse() starts with an empty Cli, so memory of a previous parse is
+    // freed first (parse_into() reuses it instead).
+    CliError parse(int argc, char** argv) noexcept {
+        cli_free(&cli);
+        return cli_parse(argc, argv, &cli);
+    }
+#ifdef CLI_NOHEAP
+    CliError parse(int argc, char** argv, const char** stack) noexcept {
+        cli_free(&cli);
+        return cli_parse_noheap(argc, argv, &cli, stack);
+    }
+#else
+    CliError parse_into(int argc, char** argv) noexcept { return cli_parse_into(argc, argv, &cli); }
+#endif
+
+    Tokens args() const noexcept { return cli.args; }
+    Tokens cmd_options() const noexcept { return cli.cmd_options; }
+    Tokens program_options() const noexcept { return cli.program_options; }
+    const ::Cli& raw() const noexcept { return cli; }
+    ::Cli& raw() noexcept { return cli; }
+
+    /*
+     * Get the program option `key` as `T`, e.g. get<int>("threads").
+     *
+     * Options of CLI_OPTIONS are read from their fields: numbers and flags
+     * convert to any arithmetic type, STRING to std::string_view and LIST to
+     * Tokens. `key` is compared with each name of the schema at run time;
+     * only option_id() is resolved at compile time. Otherwise, if
+     * `CLI_INDEX` is defined, the value is converted by cli_get_i64(),
+     * cli_get_u64() or cli_get_f64(), and `bool` tells whether the option is
+     * specified.
+     *
+     * Returns std::nullopt if the option is not specified, its value is
+     * invalid or `T` cannot hold it (e.g. get<int>() of 9999999999 or
+     * get<unsigned>() of -1).
+     */
+    template <class T> std::optional<T> get(const char* key) const noexcept {
+#ifdef CLI_OPTIONS
+#define CLI_X_CPP_GET(name, alias, kind, default_value) \
+    if (std::string_view(key) == #name) {               \
+        return detail::convert<T>(cli.options.name);    \
+    }
+        CLI_OPTIONS(CLI_X_CPP_GET)
+#undef CLI_X_CPP_GET
+#endif
+#ifdef CLI_INDEX
+        return detail::lookup<T>(cli, key);
+#else
+        (void)key;
+        return std::nullopt;
+#endif
+    }
+
+private:
+    ::Cli cli;
+};
+
+} // namespace cli
+#endif // CLI_CPP && __cplusplus
+
 #endif // __CLI_H_